@@ -6,9 +6,19 @@ Assignment: ex4
 
 #include "ex6.h"
 #include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#endif
 
 #define INT_BUFFER 128
 // Buffer size for reading directional input.
@@ -70,24 +80,26 @@ char *myStrdup(const char *src)
     char *dest = (char *)malloc(len + 1);
     if (!dest)
     {
-        printf("Memory allocation failed in myStrdup.\n");
+        outPrintf("Memory allocation failed in myStrdup.\n");
         return NULL;
     }
     strcpy(dest, src);
     return dest;
 }
-// func that reads the input carefully and validates it
-int readIntSafe(const char *prompt) {
+// func that reads the input carefully and validates it; with acceptNames a
+// species name counts as its ID
+int readIntOrSpeciesSafe(const char *prompt, int acceptNames) {
     char buffer[INT_BUFFER];
     int value;
     int success = 0;
 
     while (!success) {
-        printf("%s", prompt);
+        outPrintf("%s", prompt);
+        outFlush();
 
         // Read input
         if (!fgets(buffer, sizeof(buffer), stdin)) {
-            printf("Invalid input.\n");
+            outPrintf("Invalid input.\n");
             clearerr(stdin); // Clear the input stream error flag
             continue;
         }
@@ -100,7 +112,7 @@ int readIntSafe(const char *prompt) {
 
         // If the input is empty after trimming
         if (len == 0) {
-            printf("Invalid input.\n");
+            outPrintf("Invalid input.\n");
             continue;
         }
 
@@ -110,54 +122,69 @@ int readIntSafe(const char *prompt) {
 
         // If the entire input was not consumed, it's invalid
         if (endptr == buffer || *endptr != '\0') {
-            printf("Invalid input.\n");
+            trimWhitespace(buffer);
+            value = acceptNames ? findSpeciesIDByName(buffer) : 0;
+            if (value)
+                success = 1;
+            else
+                outPrintf("Invalid input.\n");
         } else {
             success = 1; // Valid integer input
         }
     }
     return value;
 }
+
+int readIntSafe(const char *prompt) {
+    TRACE_SPAN();
+    return readIntOrSpeciesSafe(prompt, 0);
+}
+
+int readPokemonIDSafe(const char *prompt) {
+    TRACE_SPAN();
+    return readIntOrSpeciesSafe(prompt, 1);
+}
 // func to create the pokemon node
 PokemonNode *createPokemonNode(const PokemonData *data) {
-    if (!data) return NULL;
+    const PokemonData *species = data ? getSpeciesByID(data->id) : NULL;
+    if (!species) return NULL;
 
-    PokemonNode *newNode = (PokemonNode *)malloc(sizeof(PokemonNode));
+    PokemonNode *newNode = allocPokemonNode();
     if (!newNode) {
-        printf("Memory allocation failed for PokemonNode.\n");
-        return NULL;
-    }
-
-    newNode->data = (PokemonData *)malloc(sizeof(PokemonData));
-    if (!newNode->data) {
-        printf("Memory allocation failed for PokemonData.\n");
-        free(newNode);
+        outPrintf("Memory allocation failed for PokemonNode.\n");
         return NULL;
     }
 
-    newNode->data->id = data->id;
-    newNode->data->name = myStrdup(data->name); // Duplicate string
-    newNode->data->TYPE = data->TYPE;
-    newNode->data->hp = data->hp;
-    newNode->data->attack = data->attack;
-    newNode->data->CAN_EVOLVE = data->CAN_EVOLVE;
-
-    newNode->left = newNode->right = NULL;
+    // keep only the ID; the catalog entry is found again from it
+    newNode->speciesId = (unsigned short)species->id;
+    newNode->left = newNode->right = 0;
+    newNode->refCount = 1;
+    updatePokemonSummary(newNode);
 
     return newNode;
 }
 // func to set an owner
-OwnerNode *createOwner(char *ownerName, PokemonNode *starter) {
+OwnerNode *createOwner(const char *ownerName, PokemonNode *starter) {
     if (!ownerName || !starter) return NULL;
 
     OwnerNode *newOwner = (OwnerNode *)malloc(sizeof(OwnerNode));
     if (!newOwner) {
-        printf("Memory allocation failed for OwnerNode.\n");
+        outPrintf("Memory allocation failed for OwnerNode.\n");
         return NULL;
     }
 
-    newOwner->ownerName = ownerName;
+    setOwnerName(newOwner, ownerName);
     newOwner->pokedexRoot = starter;
+    newOwner->frozen = NULL;
+    newOwner->columns = NULL;
     newOwner->next = newOwner->prev = newOwner;
+    newOwner->isRetired = 0;
+    newOwner->ownerSlot = -1;
+    memset(&newOwner->totals, 0, sizeof(newOwner->totals));
+    newOwner->retireEpoch = 0;
+    newOwner->retireNext = NULL;
+    newOwner->pinCount = 0;
+    pthread_rwlock_init(&newOwner->lock, NULL);
 
     return newOwner;
 }
@@ -210,15 +237,17 @@ const char *getTypeName(PokemonType type)
 // --------------------------------------------------------------
 char *getDynamicInput()
 {
+    TRACE_SPAN();
     char *input = NULL;
     size_t size = 0, capacity = 1;
     input = (char *)malloc(capacity);
     if (!input)
     {
-        printf("Memory allocation failed.\n");
+        outPrintf("Memory allocation failed.\n");
         return NULL;
     }
 
+    outFlush();
     int c;
     while ((c = getchar()) != '\n' && c != EOF)
     {
@@ -228,7 +257,7 @@ char *getDynamicInput()
             char *temp = (char *)realloc(input, capacity);
             if (!temp)
             {
-                printf("Memory reallocation failed.\n");
+                outPrintf("Memory reallocation failed.\n");
                 free(input);
                 return NULL;
             }
@@ -249,193 +278,257 @@ void printPokemonNode(PokemonNode *node)
 {
     if (!node)
         return;
-    printf("ID: %d, Name: %s, Type: %s, HP: %d, Attack: %d, Can Evolve: %s\n",
-           node->data->id,
-           node->data->name,
-           getTypeName(node->data->TYPE),
-           node->data->hp,
-           node->data->attack,
-           (node->data->CAN_EVOLVE == CAN_EVOLVE) ? "Yes" : "No");
+    outPrintf("ID: %d, Name: %s, Type: %s, HP: %d, Attack: %d, Can Evolve: %s\n",
+           pokemonID(node),
+           pokemonData(node)->name,
+           getTypeName(pokemonData(node)->TYPE),
+           pokemonData(node)->hp,
+           pokemonData(node)->attack,
+           (pokemonData(node)->CAN_EVOLVE == CAN_EVOLVE) ? "Yes" : "No");
 }
-// func that inserts a new Pokémon node into a binary search tree
-PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode) {
+// func that tells whether a tree holds an ID, without copying anything
+int pokemonTreeHasID(PokemonNode *root, int id) {
+    while (root && pokemonID(root) != id)
+        root = id < pokemonID(root) ? pokemonLeft(root) : pokemonRight(root);
+    return root != NULL;
+}
+
+// func that inserts a node whose ID is not in the tree yet
+PokemonNode *insertNewPokemonNode(PokemonNode *root, PokemonNode *newNode) {
     if (!root) return newNode;
 
-    if (newNode->data->id < root->data->id) {
-        root->left = insertPokemonNode(root->left, newNode);
-    } else if (newNode->data->id > root->data->id) {
-        root->right = insertPokemonNode(root->right, newNode);
-    } else {
-        // Duplicate ID, free the new node
-        freePokemonNode(newNode);
-    }
+    root = ownPokemonNode(root);
+    if (pokemonID(newNode) < pokemonID(root))
+        setPokemonLeft(root, insertNewPokemonNode(pokemonLeft(root), newNode));
+    else
+        setPokemonRight(root, insertNewPokemonNode(pokemonRight(root), newNode));
 
+    updatePokemonSummary(root);
     return root;
 }
-// func that searches pokemon (BFS)
-PokemonNode *searchPokemonBFS(PokemonNode *root, int id) {
-    if (!root) return NULL;
 
-    NodeArray queue;
-    initNodeArray(&queue, INITIAL_NODE_ARRAY_CAPACITY);
-    addNode(&queue, root);
+// func that inserts a new Pokémon node into a binary search tree
+PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode) {
+    TRACE_SPAN();
+    // look first: a duplicate must not copy the shared nodes on its path
+    if (pokemonTreeHasID(root, pokemonID(newNode))) {
+        // Duplicate ID, free the new node
+        freePokemonNode(newNode);
+        return root;
+    }
+    return insertNewPokemonNode(root, newNode);
+}
 
-    for (int i = 0; i < queue.size; i++) {
-        PokemonNode *current = queue.nodes[i];
-        if (current->data->id == id) {
-            free(queue.nodes);
-            return current;
-        }
+void updatePokemonSummary(PokemonNode *node) {
+    if (!node) return;
 
-        if (current->left) addNode(&queue, current->left);
-        if (current->right) addNode(&queue, current->right);
+    const PokemonData *data = pokemonData(node);
+    PokemonSummary *summary = pokemonSummary(node);
+    summary->typeMask = (unsigned short)(1u << data->TYPE);
+    summary->evolveMask = (unsigned char)(1u << data->CAN_EVOLVE);
+    summary->maxHp = (unsigned short)data->hp;
+    summary->maxAttack = (unsigned short)data->attack;
+    summary->size = 1;
+    summary->maxScore = pokemonScoreTenths(data);
+
+    PokemonNode *children[2] = {pokemonLeft(node), pokemonRight(node)};
+    for (int i = 0; i < 2; i++) {
+        if (!children[i]) continue;
+        const PokemonSummary *child = pokemonSummary(children[i]);
+        summary->size += child->size;
+        summary->typeMask |= child->typeMask;
+        summary->evolveMask |= child->evolveMask;
+        if (child->maxHp > summary->maxHp) summary->maxHp = child->maxHp;
+        if (child->maxAttack > summary->maxAttack) summary->maxAttack = child->maxAttack;
+        if (child->maxScore > summary->maxScore) summary->maxScore = child->maxScore;
     }
+}
+typedef struct
+{
+    int id;
+    PokemonNode *found;
+} SearchByIDContext;
+
+// visitor for searchPokemonBFS: stop as soon as the ID shows up
+int matchPokemonID(PokemonNode *node, void *ctx) {
+    SearchByIDContext *search = (SearchByIDContext *)ctx;
+    if (pokemonID(node) != search->id)
+        return 1;
+    search->found = node;
+    return 0;
+}
 
-    free(queue.nodes);
-    return NULL;
+// func that searches pokemon (BFS)
+PokemonNode *searchPokemonBFS(PokemonNode *root, int id) {
+    TRACE_SPAN();
+    SearchByIDContext search = {id, NULL};
+    traverseWithContext(root, ORDER_BFS, matchPokemonID, &search);
+    return search.found;
 }
 //func that adds a new owner to a circular doubly linked list.
 void linkOwnerInCircularList(OwnerNode *newOwner) {
-    if (!newOwner) return;
+    linkClonedOwnerInCircularList(newOwner, NULL);
+}
 
-    if (!ownerHead) {
-        ownerHead = newOwner;
-        return;
-    }
+// func that links a new owner; a clone copies its source's index entries
+void linkClonedOwnerInCircularList(OwnerNode *clone, OwnerNode *source) {
+    if (!clone) return;
 
-    OwnerNode *tail = ownerHead->prev;
-    tail->next = newOwner;
-    newOwner->prev = tail;
-    newOwner->next = ownerHead;
-    ownerHead->prev = newOwner;
+    pthread_mutex_lock(&ownerRingLock);
+    if (source)
+        indexOwnerCloned(clone, source);
+    else
+        indexOwnerLinked(clone);
+    nameTrieOwnerLinked(clone);
+    directoryInsertOwner(clone);
+    linkOwnerInRingLocked(clone, NULL, 0);
+    pthread_mutex_unlock(&ownerRingLock);
 }
 //func that will find an owner by its name.
 OwnerNode *findOwnerByName(const char *name) {
-    if (!ownerHead || !name) return NULL;
-
-    OwnerNode *current = ownerHead;
-    do {
-        if (strcmp(current->ownerName, name) == 0) {
-            return current;
-        }
-        current = current->next;
-    } while (current != ownerHead);
+    if (!name) return NULL;
+
+    int length = (int)strlen(name);
+    unsigned int hash = hashOwnerName(name, length);
+
+    // the directory holds exactly the linked owners, in name order
+    pthread_rwlock_rdlock(&ownerDirectoryLock);
+    OwnerNode *found = NULL;
+    OwnerDirectoryNode *node = ownerDirectory;
+    if (node) {
+        for (int level = ownerDirectoryLevel - 1; level >= 0; level--)
+            while (node->forward[level] && strcmp(node->forward[level]->owner->ownerName, name) < 0)
+                node = node->forward[level];
+        node = node->forward[0];
+        if (node && ownerNameEquals(node->owner, name, length, hash))
+            found = node->owner;
+    }
+    pthread_rwlock_unlock(&ownerDirectoryLock);
 
-    return NULL;
+    return found;
 }
-// remove the pokemon by choosing its id.
-PokemonNode *removePokemonByID(PokemonNode *root, int id) {
-    if (!root) return NULL;
-
+// func that removes an ID the tree is known to hold
+PokemonNode *removePresentPokemon(PokemonNode *root, int id) {
+    root = ownPokemonNode(root);
     // Traverse the tree to find the node to delete
-    if (id < root->data->id) {
-        root->left = removePokemonByID(root->left, id);
+    if (id < pokemonID(root)) {
+        setPokemonLeft(root, removePresentPokemon(pokemonLeft(root), id));
+        updatePokemonSummary(root);
         return root;
     }
 
-    if (id > root->data->id) {
-        root->right = removePokemonByID(root->right, id);
+    if (id > pokemonID(root)) {
+        setPokemonRight(root, removePresentPokemon(pokemonRight(root), id));
+        updatePokemonSummary(root);
         return root;
     }
 
     // Node to delete found
-    if (!root->left && !root->right) {
+    if (!pokemonLeft(root) && !pokemonRight(root)) {
         // Case 1: Node has no children (leaf node)
         freePokemonNode(root);
         return NULL;
     }
 
-    if (!root->left) {
+    // root is private here, so its reference to the child moves to the parent
+    if (!pokemonLeft(root)) {
         // Case 2: Node has only a right child
-        PokemonNode *temp = root->right;
+        PokemonNode *temp = pokemonRight(root);
         freePokemonNode(root);
         return temp;
     }
 
-    if (!root->right) {
+    if (!pokemonRight(root)) {
         // Case 3: Node has only a left child
-        PokemonNode *temp = root->left;
+        PokemonNode *temp = pokemonLeft(root);
         freePokemonNode(root);
         return temp;
     }
 
     // Case 4: Node has two children
     // Find the in-order successor
-    PokemonNode *successor = root->right;
-    while (successor->left) {
-        successor = successor->left;
+    PokemonNode *successor = pokemonRight(root);
+    while (pokemonLeft(successor)) {
+        successor = pokemonLeft(successor);
     }
 
     // Replace root's data with the successor's data
-    free(root->data->name);
-    root->data->name = myStrdup(successor->data->name);
-    root->data->id = successor->data->id;
-    root->data->TYPE = successor->data->TYPE;
-    root->data->hp = successor->data->hp;
-    root->data->attack = successor->data->attack;
-    root->data->CAN_EVOLVE = successor->data->CAN_EVOLVE;
+    root->speciesId = successor->speciesId;
 
     // Remove the successor node
-    root->right = removePokemonByID(root->right, successor->data->id);
+    setPokemonRight(root, removePresentPokemon(pokemonRight(root), pokemonID(successor)));
+    updatePokemonSummary(root);
     return root;
 }
+
+// remove the pokemon by choosing its id.
+PokemonNode *removePokemonByID(PokemonNode *root, int id) {
+    TRACE_SPAN();
+    // look first: a miss must not copy the shared nodes on its path
+    if (!pokemonTreeHasID(root, id)) return root;
+    return removePresentPokemon(root, id);
+}
 // --------------------------------------------------------------
 // Display Menu
 // --------------------------------------------------------------
 
 // func that opens the pokedex menu
 void openPokedexMenu() {
-    printf("Your name: ");
+    outPrintf("Your name: ");
     char *ownerName = getDynamicInput();
 
     if (!ownerName || strlen(ownerName) > MAX_OWNER_NAME_LENGTH) {
-        printf("Invalid name. Please try again.\n");
+        outPrintf("Invalid name. Please try again.\n");
         free(ownerName);
         return;
     }
 
     if (findOwnerByName(ownerName) != NULL) {
-        printf("Owner '%s' already exists. Not creating a new Pokedex.\n", ownerName);
+        outPrintf("Owner '%s' already exists. Not creating a new Pokedex.\n", ownerName);
         free(ownerName);
         return;
     }
 
-    printf("Choose Starter:\n1. Bulbasaur\n2. Charmander\n3. Squirtle\n");
+    // a loaded catalog may name its starters differently
+    outPrintf("Choose Starter:\n1. %s\n2. %s\n3. %s\n", getSpeciesByID(BULBASAUR_INDEX + 1)->name,
+              getSpeciesByID(CHARMANDER_INDEX + 1)->name, getSpeciesByID(SQUIRTLE_INDEX + 1)->name);
     int starterChoice = readIntSafe("Your choice: ");
     PokemonNode *starterNode = NULL;
 
     switch (starterChoice) {
     case 1:
-        starterNode = createPokemonNode(&pokedex[BULBASAUR_INDEX]);
+        starterNode = createPokemonNode(getSpeciesByID(BULBASAUR_INDEX + 1));
         break;
     case 2:
-        starterNode = createPokemonNode(&pokedex[CHARMANDER_INDEX]);
+        starterNode = createPokemonNode(getSpeciesByID(CHARMANDER_INDEX + 1));
         break;
     case 3:
-        starterNode = createPokemonNode(&pokedex[SQUIRTLE_INDEX]);
+        starterNode = createPokemonNode(getSpeciesByID(SQUIRTLE_INDEX + 1));
         break;
     default:
-        printf("Invalid choice. Please try again.\n");
+        outPrintf("Invalid choice. Please try again.\n");
         free(ownerName);
         return;
     }
 
     if (!starterNode) {
-        printf("Failed to create the starter Pokémon.\n");
+        outPrintf("Failed to create the starter Pokémon.\n");
         free(ownerName);
         return;
     }
 
     OwnerNode *newOwner = createOwner(ownerName, starterNode);
+    free(ownerName); // createOwner keeps its own copy
     if (!newOwner) {
-        printf("Failed to create the new owner.\n");
-        free(ownerName);
+        outPrintf("Failed to create the new owner.\n");
         freePokemonNode(starterNode);
         return;
     }
 
     linkOwnerInCircularList(newOwner);
-    printf("New Pokedex created for %s with starter %s.\n", ownerName, starterNode->data->name);
+    undoRecordLinked(newOwner);
+    undoCommit("New Pokedex");
+    outPrintf("New Pokedex created for %s with starter %s.\n", newOwner->ownerName, pokemonData(starterNode)->name);
 }
 void addNode(NodeArray *na, PokemonNode *node) {
     if (!na || !node) return;
@@ -445,7 +538,7 @@ void addNode(NodeArray *na, PokemonNode *node) {
         na->capacity *= 2;
         na->nodes = (PokemonNode **)realloc(na->nodes, na->capacity * sizeof(PokemonNode *));
         if (!na->nodes) {
-            printf("Memory reallocation failed for NodeArray.\n");
+            outPrintf("Memory reallocation failed for NodeArray.\n");
             exit(1);
         }
     }
@@ -456,7 +549,7 @@ funcs that handle the search
 ***************************/
 void displayBFS(PokemonNode *root) {
     if (!root) {
-        printf("Pokedex is empty.\n");
+        outPrintf("Pokedex is empty.\n");
         return;
     }
     BFSGeneric(root, printPokemonNode);
@@ -475,8 +568,9 @@ void postOrderTraversal(PokemonNode *root) {
 }
 
 void displayAlphabetical(PokemonNode *root) {
+    TRACE_SPAN();
     if (!root) {
-        printf("Pokedex is empty.\n");
+        outPrintf("Pokedex is empty.\n");
         return;
     }
 
@@ -494,105 +588,246 @@ void displayAlphabetical(PokemonNode *root) {
     free(nodes.nodes);
 }
 
-void BFSGeneric(PokemonNode *root, VisitNodeFunc visit) {
+// run a plain VisitNodeFunc over a cursor
+void visitAllInOrder(PokemonNode *root, TraversalOrder order, VisitNodeFunc visit) {
     if (!root || !visit) return;
 
-    // creating a dynamic queue
-    NodeArray queue;
-    initNodeArray(&queue, INITIAL_NODE_ARRAY_CAPACITY);
-
-    // adding the root
-    addNode(&queue, root);
-
-    for (int i = 0; i < queue.size; i++) {
-        PokemonNode *current = queue.nodes[i];
-
+    PokemonCursor cursor;
+    cursorInit(&cursor, root, order);
+    PokemonNode *current;
+    while ((current = cursorNext(&cursor)) != NULL)
         visit(current);
+    cursorFree(&cursor);
+}
 
-        if (current->left) addNode(&queue, current->left);
-        if (current->right) addNode(&queue, current->right);
-    }
-
-    free(queue.nodes);
+void BFSGeneric(PokemonNode *root, VisitNodeFunc visit) {
+    visitAllInOrder(root, ORDER_BFS, visit);
 }
 // does exactly what the func's name says :)
 int compareByNameNode(const void *a, const void *b) {
     PokemonNode *nodeA = *(PokemonNode **)a;
     PokemonNode *nodeB = *(PokemonNode **)b;
 
-    return strcmp(nodeA->data->name, nodeB->data->name);
+    return strcmp(pokemonData(nodeA)->name, pokemonData(nodeB)->name);
 }
 
 void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
-    if (!root || !visit) return;
-
-    visit(root);
-    preOrderGeneric(root->left, visit);
-    preOrderGeneric(root->right, visit);
+    visitAllInOrder(root, ORDER_PRE, visit);
 }
 
 void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
-    if (!root || !visit) return;
-
-    inOrderGeneric(root->left, visit);
-    visit(root);
-    inOrderGeneric(root->right, visit);
+    visitAllInOrder(root, ORDER_IN, visit);
 }
 
 void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
-    if (!root || !visit) return;
+    visitAllInOrder(root, ORDER_POST, visit);
+}
+
+// --------------------------------------------------------------
+// Cursors: pull-style traversals
+// --------------------------------------------------------------
+void cursorPush(PokemonCursor *cursor, PokemonNode *node) {
+    if (cursor->size == cursor->capacity) {
+        int newCapacity = cursor->capacity * 2;
+        PokemonNode **bigger = (PokemonNode **)malloc(sizeof(PokemonNode *) * newCapacity);
+        if (!bigger) {
+            outPrintf("Memory reallocation failed for PokemonCursor.\n");
+            exit(1);
+        }
+        // unroll the ring so head starts at 0 again
+        for (int i = 0; i < cursor->size; i++)
+            bigger[i] = cursor->items[(cursor->head + i) % cursor->capacity];
+        free(cursor->items);
+        cursor->items = bigger;
+        cursor->head = 0;
+        cursor->capacity = newCapacity;
+    }
+    cursor->items[(cursor->head + cursor->size) % cursor->capacity] = node;
+    cursor->size++;
+}
+
+// stack top is the newest element
+PokemonNode *cursorPop(PokemonCursor *cursor) {
+    cursor->size--;
+    return cursor->items[(cursor->head + cursor->size) % cursor->capacity];
+}
+
+// queue front is the oldest element
+PokemonNode *cursorDequeue(PokemonCursor *cursor) {
+    PokemonNode *node = cursor->items[cursor->head];
+    cursor->head = (cursor->head + 1) % cursor->capacity;
+    cursor->size--;
+    return node;
+}
+
+void cursorInit(PokemonCursor *cursor, PokemonNode *root, TraversalOrder order) {
+    cursor->order = order;
+    cursor->capacity = INITIAL_NODE_ARRAY_CAPACITY;
+    cursor->items = (PokemonNode **)malloc(sizeof(PokemonNode *) * cursor->capacity);
+    if (!cursor->items) {
+        outPrintf("Memory allocation failed for PokemonCursor.\n");
+        exit(1);
+    }
+    cursor->head = cursor->size = 0;
+    cursor->pending = NULL;
+    cursor->lastVisited = NULL;
+
+    if (!root) return;
+    if (order == ORDER_IN || order == ORDER_POST)
+        cursor->pending = root; // descended lazily in cursorNext
+    else
+        cursorPush(cursor, root);
+}
+
+PokemonNode *cursorNext(PokemonCursor *cursor) {
+    PokemonNode *node;
+
+    switch (cursor->order) {
+    case ORDER_BFS:
+        if (cursor->size == 0) return NULL;
+        node = cursorDequeue(cursor);
+        if (pokemonLeft(node)) cursorPush(cursor, pokemonLeft(node));
+        if (pokemonRight(node)) cursorPush(cursor, pokemonRight(node));
+        return node;
+
+    case ORDER_PRE:
+        if (cursor->size == 0) return NULL;
+        node = cursorPop(cursor);
+        // right first so left comes out first
+        if (pokemonRight(node)) cursorPush(cursor, pokemonRight(node));
+        if (pokemonLeft(node)) cursorPush(cursor, pokemonLeft(node));
+        return node;
+
+    case ORDER_IN:
+        while (cursor->pending) {
+            cursorPush(cursor, cursor->pending);
+            cursor->pending = pokemonLeft(cursor->pending);
+        }
+        if (cursor->size == 0) return NULL;
+        node = cursorPop(cursor);
+        cursor->pending = pokemonRight(node);
+        return node;
+
+    case ORDER_POST:
+        for (;;) {
+            while (cursor->pending) {
+                cursorPush(cursor, cursor->pending);
+                cursor->pending = pokemonLeft(cursor->pending);
+            }
+            if (cursor->size == 0) return NULL;
+            node = cursor->items[(cursor->head + cursor->size - 1) % cursor->capacity];
+            // finish the right subtree before the node itself
+            if (pokemonRight(node) && cursor->lastVisited != pokemonRight(node)) {
+                cursor->pending = pokemonRight(node);
+                continue;
+            }
+            cursorPop(cursor);
+            cursor->lastVisited = node;
+            return node;
+        }
+    }
+    return NULL;
+}
 
-    postOrderGeneric(root->left, visit);
-    postOrderGeneric(root->right, visit);
-    visit(root);
+void cursorInitAtRank(PokemonCursor *cursor, PokemonNode *root, int k) {
+    cursorInit(cursor, NULL, ORDER_IN);
+
+    // stack up the ancestors we pass on the left, exactly as an in-order walk would
+    PokemonNode *node = root;
+    while (node) {
+        int leftSize = pokemonTreeSize(pokemonLeft(node));
+        if (k < leftSize) {
+            cursorPush(cursor, node);
+            node = pokemonLeft(node);
+        } else if (k == leftSize) {
+            cursorPush(cursor, node);
+            break;
+        } else {
+            k -= leftSize + 1;
+            node = pokemonRight(node);
+        }
+    }
+}
+
+void cursorFree(PokemonCursor *cursor) {
+    free(cursor->items);
+    cursor->items = NULL;
+    cursor->size = cursor->capacity = 0;
+}
+
+int traverseWithContext(PokemonNode *root, TraversalOrder order, VisitNodeCtxFunc visit, void *ctx) {
+    if (!root || !visit) return 0;
+
+    PokemonCursor cursor;
+    cursorInit(&cursor, root, order);
+    int stopped = 0;
+    PokemonNode *current;
+    while (!stopped && (current = cursorNext(&cursor)) != NULL)
+        stopped = !visit(current, ctx);
+    cursorFree(&cursor);
+    return stopped;
 }
 // --------------------------------------------------------------
 // Sub-menu for existing Pokedex
 // --------------------------------------------------------------
 void enterExistingPokedexMenu() {
-    if (!ownerHead) {
-        printf("No existing Pokedexes.\n");
+    // the read section only covers the listing; the chosen owner is pinned for
+    // the submenu, so no section stays open while we wait for input
+    unsigned long epoch = ringReadBegin();
+    OwnerNode *head = getOwnerHead();
+    if (!head) {
+        outPrintf("No existing Pokedexes.\n");
+        ringReadEnd(epoch);
         return;
     }
 
-    printf("\nExisting Pokedexes:\n");
-    OwnerNode *current = ownerHead;
+    outPrintf("\nExisting Pokedexes:\n");
+    OwnerNode *current = head;
     int index = 1;
 
     // display all owners
     do {
-        printf("%d. %s\n", index++, current->ownerName);
-        current = current->next;
-    } while (current != ownerHead);
+        outPrintf("%d. %s\n", index++, current->ownerName);
+        current = ownerNext(current);
+    } while (current != head);
+    ringReadEnd(epoch);
 
     int choice = readIntSafe("Choose a Pokedex by number:\n");
 
-    if (choice < 1 || choice >= index) {
-        printf("Invalid choice.\n");
-        return;
-    }
-
     // find a specific owner
-    current = ownerHead;
-    for (int i = 1; i < choice; i++) {
-        current = current->next;
+    current = NULL;
+    if (choice >= 1 && choice < index) {
+        epoch = ringReadBegin();
+        current = ownerAtPosition(choice);
+        if (current) pinOwner(current);
+        ringReadEnd(epoch);
+    }
+    if (!current) {
+        outPrintf("Invalid choice.\n");
+        return;
     }
 
-    printf("\nEntering %s's Pokedex...\n", current->ownerName);
+    outPrintf("\nEntering %s's Pokedex...\n", current->ownerName);
 
 //pokedex menu
     int subChoice;
     do {
-        printf("\n-- %s's Pokedex Menu --\n", current->ownerName);
-        printf("1. Add Pokemon\n");
-        printf("2. Display Pokedex\n");
-        printf("3. Release Pokemon (by ID)\n");
-        printf("4. Pokemon Fight!\n");
-        printf("5. Evolve Pokemon\n");
-        printf("6. Back to Main\n");
+        outPrintf("\n-- %s's Pokedex Menu --\n", current->ownerName);
+        outPrintf("1. Add Pokemon\n");
+        outPrintf("2. Display Pokedex\n");
+        outPrintf("3. Release Pokemon (by ID)\n");
+        outPrintf("4. Pokemon Fight!\n");
+        outPrintf("5. Evolve Pokemon\n");
+        outPrintf("6. Back to Main\n");
+        outPrintf("7. Query Pokedex\n");
+        outPrintf("8. Top Pokemon\n");
+        outPrintf("9. Freeze Pokedex\n");
+        outPrintf("10. Pokedex Stats\n");
+        outPrintf("11. Battle Simulation\n");
 
         subChoice = readIntSafe("Your choice: ");
 
+        TraceSpan action = traceSpanBegin("Owner menu action", subChoice);
         switch (subChoice) {
             case 1:
                 addPokemon(current);
@@ -610,47 +845,94 @@ void enterExistingPokedexMenu() {
                 evolvePokemon(current);
                 break;
             case 6:
-                printf("Back to Main Menu.\n");
+                outPrintf("Back to Main Menu.\n");
+                break;
+            case 7:
+                queryPokedexMenu(current);
+                break;
+            case 8:
+                ownerLeaderboardMenu(current);
+                break;
+            case 9:
+                freezePokedexMenu(current);
+                break;
+            case 10:
+                ownerStatsMenu(current);
+                break;
+            case 11:
+                battleSimulationMenu(current);
                 break;
             default:
-                printf("Invalid choice.\n");
+                outPrintf("Invalid choice.\n");
         }
+        traceSpanEnd(&action);
     } while (subChoice != 6);
+    unpinOwner(current);
 }
 
 // add pokemon func
 void addPokemon(OwnerNode *owner) {
-    printf("Enter ID to add: ");
-    int id = readIntSafe("");
+    outPrintf("Enter ID to add: ");
+    int id = readPokemonIDSafe("");
+    const PokemonData *species = getSpeciesByID(id);
+    if (!species) {
+        outPrintf("Invalid ID.\n");
+        return;
+    }
 
+    lockOwnerWrite(owner);
     // check if the pokemon already
     PokemonNode *existing = searchPokemonBFS(owner->pokedexRoot, id);
     if (existing) {
-        printf("Pokemon with ID %d is already in the Pokedex. No changes made.\n", id);
+        outPrintf("Pokemon with ID %d is already in the Pokedex. No changes made.\n", id);
+        unlockOwner(owner);
         return;
     }
 
     // creating new pokemon to the tree
-    PokemonNode *newNode = createPokemonNode(&pokedex[id - 1]);
+    thawPokedex(owner);
+    PokemonNode *before = sharePokemonTree(owner->pokedexRoot);
+    PokemonNode *newNode = createPokemonNode(species);
     owner->pokedexRoot = insertPokemonNode(owner->pokedexRoot, newNode);
-    printf("Pokemon %s (ID %d) added.\n", pokedex[id - 1].name, id);
+    indexPokemonAdded(owner, id);
+    undoRecordRoot(owner, before);
+    outPrintf("Pokemon %s (ID %d) added.\n", species->name, id);
+    unlockOwner(owner);
+    undoCommit("Add Pokemon");
 }
 
 void displayMenu(OwnerNode *owner) {
-    if (!owner->pokedexRoot) {
-        printf("Pokedex is empty.\n");
+    lockOwnerRead(owner);
+    int isEmpty = owner->pokedexRoot == NULL;
+    unlockOwner(owner);
+    if (isEmpty) {
+        outPrintf("Pokedex is empty.\n");
         return;
     }
 
-    printf("Display:\n");
-    printf("1. BFS (Level-Order)\n");
-    printf("2. Pre-Order\n");
-    printf("3. In-Order\n");
-    printf("4. Post-Order\n");
-    printf("5. Alphabetical (by name)\n");
+    outPrintf("Display:\n");
+    outPrintf("1. BFS (Level-Order)\n");
+    outPrintf("2. Pre-Order\n");
+    outPrintf("3. In-Order\n");
+    outPrintf("4. Post-Order\n");
+    outPrintf("5. Alphabetical (by name)\n");
+    outPrintf("6. Paged (by ID)\n");
+    outPrintf("7. Pokemon at Position\n");
+    outPrintf("8. Position of ID\n");
 
     int choice = readIntSafe("Your choice: ");
 
+    // these ask more questions, so they take the lock themselves
+    if (choice == 6) {
+        displayPagedMenu(owner);
+        return;
+    }
+    if (choice == 7 || choice == 8) {
+        displayRankMenu(owner, choice == 7);
+        return;
+    }
+
+    lockOwnerRead(owner);
     switch (choice) {
         case 1:
             displayBFS(owner->pokedexRoot);
@@ -668,158 +950,369 @@ void displayMenu(OwnerNode *owner) {
             displayAlphabetical(owner->pokedexRoot);
             break;
         default:
-            printf("Invalid choice.\n");
+            outPrintf("Invalid choice.\n");
+    }
+    unlockOwner(owner);
+}
+
+int pokemonTreeSize(const PokemonNode *node) {
+    return node ? pokemonSummary(node)->size : 0;
+}
+
+PokemonNode *selectPokemonByRank(PokemonNode *root, int k) {
+    PokemonNode *node = root;
+    while (node) {
+        int leftSize = pokemonTreeSize(pokemonLeft(node));
+        if (k <= leftSize) {
+            node = pokemonLeft(node);
+        } else if (k == leftSize + 1) {
+            return node;
+        } else {
+            k -= leftSize + 1;
+            node = pokemonRight(node);
+        }
+    }
+    return NULL;
+}
+
+int rankOfPokemonID(PokemonNode *root, int id) {
+    int smaller = 0;
+    PokemonNode *node = root;
+    while (node) {
+        if (id <= pokemonID(node)) {
+            node = pokemonLeft(node);
+        } else {
+            smaller += pokemonTreeSize(pokemonLeft(node)) + 1;
+            node = pokemonRight(node);
+        }
+    }
+    return smaller;
+}
+
+int displayPokedexPage(PokemonNode *root, int offset, int limit) {
+    PokemonCursor cursor;
+    cursorInitAtRank(&cursor, root, offset);
+    int printed = 0;
+    PokemonNode *node;
+    while (printed < limit && (node = cursorNext(&cursor)) != NULL) {
+        printPokemonNode(node);
+        printed++;
+    }
+    cursorFree(&cursor);
+    return printed;
+}
+
+void displayPagedMenu(OwnerNode *owner) {
+    int pageSize = readIntSafe("Page size: ");
+    if (pageSize < 1) {
+        outPrintf("Invalid choice.\n");
+        return;
+    }
+    int page = readIntSafe("Page number: ");
+
+    lockOwnerRead(owner);
+    int total = pokemonTreeSize(owner->pokedexRoot);
+    // no (total + pageSize - 1) here: a large page size would overflow it
+    int pages = total / pageSize + (total % pageSize != 0);
+    if (page < 1 || page > pages) {
+        outPrintf("Invalid choice.\n");
+    } else {
+        outPrintf("Page %d of %d (%d Pokemon):\n", page, pages, total);
+        // page <= pages keeps the offset below total, so it fits in an int
+        displayPokedexPage(owner->pokedexRoot, (int)((long long)(page - 1) * pageSize), pageSize);
+    }
+    unlockOwner(owner);
+}
+
+void displayRankMenu(OwnerNode *owner, int byPosition) {
+    if (byPosition) {
+        int position = readIntSafe("Position (1 = lowest ID): ");
+        lockOwnerRead(owner);
+        int total = pokemonTreeSize(owner->pokedexRoot);
+        PokemonNode *node = selectPokemonByRank(owner->pokedexRoot, position);
+        if (!node) {
+            outPrintf("Invalid choice.\n");
+        } else {
+            outPrintf("Position %d of %d:\n", position, total);
+            printPokemonNode(node);
+        }
+        unlockOwner(owner);
+        return;
+    }
+
+    outPrintf("Enter Pokemon ID: ");
+    int id = readPokemonIDSafe("");
+    if (!getSpeciesByID(id)) {
+        outPrintf("Invalid ID.\n");
+        return;
+    }
+    lockOwnerRead(owner);
+    int total = pokemonTreeSize(owner->pokedexRoot);
+    int smaller = rankOfPokemonID(owner->pokedexRoot, id);
+    PokemonNode *next = selectPokemonByRank(owner->pokedexRoot, smaller + 1);
+    if (next && pokemonID(next) == id)
+        outPrintf("ID %d is at position %d of %d.\n", id, smaller + 1, total);
+    else
+        outPrintf("ID %d is not in the Pokedex; %d of %d Pokemon have a lower ID.\n", id, smaller,
+                  total);
+    unlockOwner(owner);
+}
+
+// can anything in this subtree pass the type/stat/evolve filters?
+int subtreeMayMatch(const PokemonNode *node, const PokemonQuery *query) {
+    const PokemonSummary *summary = pokemonSummary(node);
+    if (query->typeMask && !(summary->typeMask & query->typeMask)) return 0;
+    if (summary->maxHp < query->minHp) return 0;
+    if (summary->maxAttack < query->minAttack) return 0;
+    if (query->evolve >= 0 && !(summary->evolveMask & (1u << query->evolve))) return 0;
+    return 1;
+}
+
+int pokemonMatchesQuery(const PokemonData *data, const PokemonQuery *query) {
+    return data->id >= query->minID && data->id <= query->maxID &&
+           (!query->typeMask || (query->typeMask & (1u << data->TYPE))) &&
+           data->hp >= query->minHp &&
+           data->attack >= query->minAttack &&
+           (query->evolve < 0 || (int)data->CAN_EVOLVE == query->evolve);
+}
+
+int queryPokedex(PokemonNode *root, const PokemonQuery *query, VisitNodeCtxFunc emit, void *ctx) {
+    if (!root || !subtreeMayMatch(root, query)) return 0;
+
+    // only go left/right if part of the ID range can be there
+    if (pokemonID(root) > query->minID && queryPokedex(pokemonLeft(root), query, emit, ctx))
+        return 1;
+    if (pokemonMatchesQuery(pokemonData(root), query) && !emit(root, ctx))
+        return 1;
+    if (pokemonID(root) < query->maxID)
+        return queryPokedex(pokemonRight(root), query, emit, ctx);
+    return 0;
+}
+
+// visitor for queryPokedexMenu: print and count
+int printQueryMatch(PokemonNode *node, void *ctx) {
+    printPokemonNode(node);
+    (*(int *)ctx)++;
+    return 1;
+}
+
+int readPokemonQuery(PokemonQuery *query) {
+    query->minID = readIntSafe("Min ID: ");
+    query->maxID = readIntSafe("Max ID: ");
+
+    outPrintf("Type (0 = any");
+    for (int t = 0; t < POKEMON_TYPE_COUNT; t++)
+        outPrintf(", %d = %s", t + 1, getTypeName((PokemonType)t));
+    outPrintf("): ");
+    int type = readIntSafe("");
+    if (type < 0 || type > POKEMON_TYPE_COUNT) {
+        outPrintf("Invalid choice.\n");
+        return 0;
+    }
+    query->typeMask = type == 0 ? 0 : 1u << (type - 1);
+
+    query->minHp = readIntSafe("Min HP: ");
+    query->minAttack = readIntSafe("Min Attack: ");
+
+    int evolve = readIntSafe("Can evolve (0 = any, 1 = yes, 2 = no): ");
+    if (evolve == 0)
+        query->evolve = -1;
+    else if (evolve == 1)
+        query->evolve = CAN_EVOLVE;
+    else if (evolve == 2)
+        query->evolve = CANNOT_EVOLVE;
+    else {
+        outPrintf("Invalid choice.\n");
+        return 0;
     }
+    return 1;
+}
+
+void queryPokedexMenu(OwnerNode *owner) {
+    PokemonQuery query;
+    if (!readPokemonQuery(&query))
+        return;
+
+    int matches = 0;
+    lockOwnerRead(owner);
+    queryPokedex(owner->pokedexRoot, &query, printQueryMatch, &matches);
+    unlockOwner(owner);
+
+    if (matches == 0)
+        outPrintf("No Pokemon matched the query.\n");
+    else
+        outPrintf("%d Pokemon matched.\n", matches);
 }
 
 void freePokemon(OwnerNode *owner) {
-    if (!owner->pokedexRoot) {
-        printf("No Pokemon to release.\n");
+    lockOwnerRead(owner);
+    int isEmpty = owner->pokedexRoot == NULL;
+    unlockOwner(owner);
+    if (isEmpty) {
+        outPrintf("No Pokemon to release.\n");
         return;
     }
 
-    printf("Enter Pokemon ID to release: "); // Updated prompt
-    int id = readIntSafe("");
+    outPrintf("Enter Pokemon ID to release: "); // Updated prompt
+    int id = readPokemonIDSafe("");
 
+    lockOwnerWrite(owner);
     // Find the Pokemon by ID
     PokemonNode *pokemon = searchPokemonBFS(owner->pokedexRoot, id);
     if (pokemon) {
         // Print the correct removal message
-        printf("Removing Pokemon %s (ID %d).\n", pokemon->data->name, id);
+        outPrintf("Removing Pokemon %s (ID %d).\n", pokemonData(pokemon)->name, id);
+        thawPokedex(owner);
+        PokemonNode *before = sharePokemonTree(owner->pokedexRoot);
         owner->pokedexRoot = removePokemonByID(owner->pokedexRoot, id);
+        indexPokemonRemoved(owner, id);
+        undoRecordRoot(owner, before);
     } else {
         // Handle the case when the ID is not found
-        printf("No Pokemon with ID %d found.\n", id);
+        outPrintf("No Pokemon with ID %d found.\n", id);
     }
+    unlockOwner(owner);
+    undoCommit("Release Pokemon");
 }
 //
 void pokemonFight(OwnerNode *owner) {
-    if (!owner->pokedexRoot) {
-        printf("Pokedex is empty.\n");
+    lockOwnerRead(owner);
+    int isEmpty = owner->pokedexRoot == NULL;
+    unlockOwner(owner);
+    if (isEmpty) {
+        outPrintf("Pokedex is empty.\n");
         return;
     }
 
-    printf("Enter ID of the first Pokemon: ");
-    int id1 = readIntSafe("");
+    outPrintf("Enter ID of the first Pokemon: ");
+    int id1 = readPokemonIDSafe("");
 
-    printf("Enter ID of the second Pokemon: ");
-    int id2 = readIntSafe("");
+    outPrintf("Enter ID of the second Pokemon: ");
+    int id2 = readPokemonIDSafe("");
 
-    PokemonNode *pokemon1 = searchPokemonBFS(owner->pokedexRoot, id1);
-    PokemonNode *pokemon2 = searchPokemonBFS(owner->pokedexRoot, id2);
+    lockOwnerRead(owner);
+    const PokemonData *pokemon1 = findOwnedPokemon(owner, id1);
+    const PokemonData *pokemon2 = findOwnedPokemon(owner, id2);
 
     if (!pokemon1 || !pokemon2) {
-        printf("One or both Pokemon IDs not found.\n");
+        outPrintf("One or both Pokemon IDs not found.\n");
+        unlockOwner(owner);
         return;
     }
 
-    double score1 = pokemon1->data->attack * 1.5 + pokemon1->data->hp * 1.2;
-    double score2 = pokemon2->data->attack * 1.5 + pokemon2->data->hp * 1.2;
+    double score1 = pokemon1->attack * 1.5 + pokemon1->hp * 1.2;
+    double score2 = pokemon2->attack * 1.5 + pokemon2->hp * 1.2;
 
     // Correctly formatted output with line breaks
-    printf("Pokemon 1: %s (Score = %.2f)\n", pokemon1->data->name, score1);
-    printf("Pokemon 2: %s (Score = %.2f)\n", pokemon2->data->name, score2);
+    outPrintf("Pokemon 1: %s (Score = %.2f)\n", pokemon1->name, score1);
+    outPrintf("Pokemon 2: %s (Score = %.2f)\n", pokemon2->name, score2);
 
     if (score1 > score2)
-        printf("%s wins!\n", pokemon1->data->name);
+        outPrintf("%s wins!\n", pokemon1->name);
     else if (score2 > score1)
-        printf("%s wins!\n", pokemon2->data->name);
+        outPrintf("%s wins!\n", pokemon2->name);
     else
-        printf("It's a tie!\n");
+        outPrintf("It's a tie!\n");
+    unlockOwner(owner);
 }
 // func that evolves the pokemon
 void evolvePokemon(OwnerNode *owner) {
-    if (!owner->pokedexRoot) {
-        printf("Cannot evolve. Pokedex empty.\n");
+    lockOwnerRead(owner);
+    int isEmpty = owner->pokedexRoot == NULL;
+    unlockOwner(owner);
+    if (isEmpty) {
+        outPrintf("Cannot evolve. Pokedex empty.\n");
         return;
     }
 
-    printf("Enter ID of Pokemon to evolve: ");
-    int oldID = readIntSafe("");
+    outPrintf("Enter ID of Pokemon to evolve: ");
+    int oldID = readPokemonIDSafe("");
 
+    lockOwnerWrite(owner);
     PokemonNode *pokemon = searchPokemonBFS(owner->pokedexRoot, oldID);
     if (!pokemon) {
-        printf("No Pokemon with ID %d found.\n", oldID);
+        outPrintf("No Pokemon with ID %d found.\n", oldID);
+        unlockOwner(owner);
         return;
     }
 
-    if (pokemon->data->CAN_EVOLVE == CANNOT_EVOLVE) {
-        printf("Pokemon %s (ID %d) cannot evolve.\n", pokemon->data->name, oldID);
+    if (pokemonData(pokemon)->CAN_EVOLVE == CANNOT_EVOLVE) {
+        outPrintf("Pokemon %s (ID %d) cannot evolve.\n", pokemonData(pokemon)->name, oldID);
+        unlockOwner(owner);
         return;
     }
 
     int newID = oldID + 1;
 
     // Create the new evolved Pokemon
-    PokemonNode *newPokemon = createPokemonNode(&pokedex[newID - 1]);
+    PokemonNode *newPokemon = createPokemonNode(getSpeciesByID(newID));
     if (!newPokemon) {
-        printf("Failed to create evolved Pokemon.\n");
+        outPrintf("Failed to create evolved Pokemon.\n");
+        unlockOwner(owner);
         return;
     }
 
-    // Save old name before freeing
-    char *oldName = myStrdup(pokemon->data->name);
+    // species data is shared, so the name outlives the node
+    const char *oldName = pokemonData(pokemon)->name;
 
-    printf("Removing Pokemon %s (ID %d).\n", oldName, oldID);
+    outPrintf("Removing Pokemon %s (ID %d).\n", oldName, oldID);
 
+    thawPokedex(owner);
+    PokemonNode *before = sharePokemonTree(owner->pokedexRoot);
     owner->pokedexRoot = removePokemonByID(owner->pokedexRoot, oldID);
+    // insert frees newPokemon if the evolved form was already there
     owner->pokedexRoot = insertPokemonNode(owner->pokedexRoot, newPokemon);
+    indexPokemonRemoved(owner, oldID);
+    indexPokemonAdded(owner, newID);
+    undoRecordRoot(owner, before);
 
-    printf("Pokemon evolved from %s (ID %d) to %s (ID %d).\n",
-           oldName, oldID, newPokemon->data->name, newID);
+    outPrintf("Pokemon evolved from %s (ID %d) to %s (ID %d).\n",
+           oldName, oldID, getSpeciesByID(newID)->name, newID);
 
-    free(oldName); // cleanup
+    unlockOwner(owner);
+    undoCommit("Evolve Pokemon");
 }
 // func to delete the pokedex
 void deletePokedex() {
-    if (!ownerHead) {
-        printf("No existing Pokedexes to delete.\n");
+    unsigned long epoch = ringReadBegin();
+    OwnerNode *head = getOwnerHead();
+    if (!head) {
+        outPrintf("No existing Pokedexes to delete.\n");
+        ringReadEnd(epoch);
         return;
     }
 
-    printf("\n=== Delete a Pokedex ===\n");
+    outPrintf("\n=== Delete a Pokedex ===\n");
 
     // Display all owners
-    OwnerNode *current = ownerHead;
+    OwnerNode *current = head;
     int index = 1;
 
     do {
-        printf("%d. %s\n", index++, current->ownerName);
-        current = current->next;
-    } while (current != ownerHead);
+        outPrintf("%d. %s\n", index++, current->ownerName);
+        current = ownerNext(current);
+    } while (current != head);
+    ringReadEnd(epoch);
 
     int choice = readIntSafe("Choose a Pokedex to delete by number: ");
 
-    if (choice < 1 || choice >= index) {
-        printf("Invalid choice.\n");
+    // Find the selected owner in a new read section
+    epoch = ringReadBegin();
+    current = choice >= 1 && choice < index ? ownerAtPosition(choice) : NULL;
+    if (!current) {
+        outPrintf("Invalid choice.\n");
+        ringReadEnd(epoch);
         return;
     }
 
-    // Find the selected owner
-    current = ownerHead;
-    for (int i = 1; i < choice; i++) {
-        current = current->next;
-    }
-
-    printf("Deleting %s's entire Pokedex...\n", current->ownerName);
-
-    // Update the circular doubly linked list
-    if (current->next == current && current->prev == current) {
-        // Only one owner in the list
-        ownerHead = NULL;
-    } else {
-        // More than one owner
-        current->prev->next = current->next;
-        current->next->prev = current->prev;
-        if (current == ownerHead) {
-            ownerHead = current->next; // Update head if necessary
-        }
-    }
+    outPrintf("Deleting %s's entire Pokedex...\n", current->ownerName);
 
-    // Free the memory
-    freeOwnerNode(current);
+    // Unlink from the ring; the memory is reclaimed once no reader can see it
+    removeOwnerFromCircularList(current);
+    undoCommit("Delete Pokedex");
+    ringReadEnd(epoch);
 
-    printf("Pokedex deleted.\n");
+    outPrintf("Pokedex deleted.\n");
 }
 
 /**
@@ -830,10 +1323,13 @@ void freeOwnerNode(OwnerNode *owner) {
     if (!owner) return;
 
     // Free the Pokedex BST
+    thawPokedex(owner);
     freePokemonTree(owner->pokedexRoot);
 
     // Free the owner's name
-    free(owner->ownerName);
+    clearOwnerName(owner);
+
+    pthread_rwlock_destroy(&owner->lock);
 
     // Free the owner node itself
     free(owner);
@@ -846,12 +1342,40 @@ void freeOwnerNode(OwnerNode *owner) {
 void freePokemonTree(PokemonNode *root) {
     if (!root) return;
 
-    freePokemonTree(root->left);
-    freePokemonTree(root->right);
+    // still part of another Pokedex
+    if (__atomic_sub_fetch(&root->refCount, 1, __ATOMIC_ACQ_REL) != 0) return;
+
+    freePokemonTree(pokemonLeft(root));
+    freePokemonTree(pokemonRight(root));
 
     freePokemonNode(root);
 }
 
+PokemonNode *sharePokemonTree(PokemonNode *root) {
+    if (root) __atomic_add_fetch(&root->refCount, 1, __ATOMIC_RELAXED);
+    return root;
+}
+
+// func that copies a shared node so the caller can modify it
+PokemonNode *ownPokemonNode(PokemonNode *node) {
+    if (__atomic_load_n(&node->refCount, __ATOMIC_ACQUIRE) == 1) return node;
+
+    PokemonNode *copy = allocPokemonNode();
+    if (!copy) {
+        outPrintf("Memory allocation failed for PokemonNode.\n");
+        exit(1);
+    }
+    *copy = *node;
+    copy->refCount = 1;
+    *pokemonSummary(copy) = *pokemonSummary(node);
+    sharePokemonTree(pokemonLeft(copy));
+    sharePokemonTree(pokemonRight(copy));
+
+    // drop our reference; frees the original if the other side let go meanwhile
+    freePokemonTree(node);
+    return copy;
+}
+
 /**
  * @brief Free a single PokemonNode, including its data.
  * @param node pointer to the PokemonNode to free
@@ -859,72 +1383,197 @@ void freePokemonTree(PokemonNode *root) {
 void freePokemonNode(PokemonNode *node) {
     if (!node) return;
 
-    // Free the Pokemon's name
-    free(node->data->name);
+    // The species data is shared; only the node goes back to the pool
+    releasePokemonNode(node);
+}
+
+// Sanitizer builds poison pooled nodes while they are free, so use-after-free
+// is still reported
+#if defined(__SANITIZE_ADDRESS__)
+#define POISON_POOL_NODE(chunk, slot)                                                   \
+    do {                                                                                \
+        ASAN_POISON_MEMORY_REGION(&(chunk)->nodes[slot], sizeof(PokemonNode));          \
+        ASAN_POISON_MEMORY_REGION(&(chunk)->summaries[slot], sizeof(PokemonSummary));   \
+    } while (0)
+#define UNPOISON_POOL_NODE(chunk, slot)                                                 \
+    do {                                                                                \
+        ASAN_UNPOISON_MEMORY_REGION(&(chunk)->nodes[slot], sizeof(PokemonNode));        \
+        ASAN_UNPOISON_MEMORY_REGION(&(chunk)->summaries[slot], sizeof(PokemonSummary)); \
+    } while (0)
+#else
+#define POISON_POOL_NODE(chunk, slot) ((void)0)
+#define UNPOISON_POOL_NODE(chunk, slot) ((void)0)
+#endif
+
+// the node size is the point of the pool layout (32 bytes per entry with its
+// summary); the chunk size must be a power of two
+typedef char pokemonNodeIs16Bytes[sizeof(PokemonNode) == 16 ? 1 : -1];
+typedef char pokemonSummaryIs16Bytes[sizeof(PokemonSummary) == 16 ? 1 : -1];
+typedef char nodePoolChunkIsPowerOfTwo[(sizeof(NodePoolChunk) & (sizeof(NodePoolChunk) - 1)) == 0 ? 1 : -1];
+
+// func that finds the chunk a node was carved from
+NodePoolChunk *nodePoolChunkOf(const PokemonNode *node) {
+    return (NodePoolChunk *)((uintptr_t)node & ~(uintptr_t)(sizeof(NodePoolChunk) - 1));
+}
 
-    // Free the PokemonData struct
-    free(node->data);
+PokemonNode *nodeAtPoolIndex(unsigned int index) {
+    if (index == 0) return NULL;
+    return &nodePoolChunks[index / NODE_POOL_CHUNK_SIZE]->nodes[index % NODE_POOL_CHUNK_SIZE];
+}
 
-    // Free the node itself
-    free(node);
+unsigned int poolIndexOfNode(const PokemonNode *node) {
+    if (!node) return 0;
+    NodePoolChunk *chunk = nodePoolChunkOf(node);
+    return chunk->nodes[0].left * NODE_POOL_CHUNK_SIZE + (unsigned int)(node - chunk->nodes);
+}
+
+PokemonNode *pokemonLeft(const PokemonNode *node) {
+    return nodeAtPoolIndex(node->left);
+}
+
+PokemonNode *pokemonRight(const PokemonNode *node) {
+    return nodeAtPoolIndex(node->right);
+}
+
+void setPokemonLeft(PokemonNode *node, PokemonNode *child) {
+    node->left = poolIndexOfNode(child);
+}
+
+void setPokemonRight(PokemonNode *node, PokemonNode *child) {
+    node->right = poolIndexOfNode(child);
+}
+
+int pokemonID(const PokemonNode *node) {
+    return node->speciesId;
+}
+
+const PokemonData *pokemonData(const PokemonNode *node) {
+    return &speciesCatalog[node->speciesId - 1];
+}
+
+PokemonSummary *pokemonSummary(const PokemonNode *node) {
+    NodePoolChunk *chunk = nodePoolChunkOf(node);
+    return &chunk->summaries[node - chunk->nodes];
+}
+
+PokemonNode *allocPokemonNode() {
+    pthread_mutex_lock(&nodePoolLock);
+    PokemonNode *node;
+    if (nodePoolFree) {
+        NodePoolChunk *chunk = nodePoolChunks[nodePoolFree / NODE_POOL_CHUNK_SIZE];
+        UNPOISON_POOL_NODE(chunk, nodePoolFree % NODE_POOL_CHUNK_SIZE);
+        node = &chunk->nodes[nodePoolFree % NODE_POOL_CHUNK_SIZE];
+        nodePoolFree = node->left;
+    } else {
+        if (nodePoolChunkUsed == NODE_POOL_CHUNK_SIZE) {
+            void *memory = NULL;
+            if (nodePoolChunkCount == NODE_POOL_MAX_CHUNKS ||
+                posix_memalign(&memory, sizeof(NodePoolChunk), sizeof(NodePoolChunk)) != 0) {
+                pthread_mutex_unlock(&nodePoolLock);
+                return NULL;
+            }
+            NodePoolChunk *chunk = (NodePoolChunk *)memory;
+            chunk->nodes[0].left = (unsigned int)nodePoolChunkCount;
+            for (int slot = 1; slot < NODE_POOL_CHUNK_SIZE; slot++)
+                POISON_POOL_NODE(chunk, slot);
+            nodePoolChunks[nodePoolChunkCount++] = chunk;
+            nodePoolChunkUsed = 1; // slot 0 is the chunk header
+        }
+        NodePoolChunk *chunk = nodePoolChunks[nodePoolChunkCount - 1];
+        UNPOISON_POOL_NODE(chunk, nodePoolChunkUsed);
+        node = &chunk->nodes[nodePoolChunkUsed++];
+    }
+    pthread_mutex_unlock(&nodePoolLock);
+    return node;
+}
+
+void releasePokemonNode(PokemonNode *node) {
+    unsigned int index = poolIndexOfNode(node);
+    pthread_mutex_lock(&nodePoolLock);
+    node->left = nodePoolFree;
+    nodePoolFree = index;
+    POISON_POOL_NODE(nodePoolChunkOf(node), index % NODE_POOL_CHUNK_SIZE);
+    pthread_mutex_unlock(&nodePoolLock);
+}
+
+void freeNodePool() {
+    pthread_mutex_lock(&nodePoolLock);
+    for (int i = 0; i < nodePoolChunkCount; i++) {
+        for (int slot = 1; slot < NODE_POOL_CHUNK_SIZE; slot++)
+            UNPOISON_POOL_NODE(nodePoolChunks[i], slot);
+        free(nodePoolChunks[i]);
+        nodePoolChunks[i] = NULL;
+    }
+    nodePoolChunkCount = 0;
+    nodePoolChunkUsed = NODE_POOL_CHUNK_SIZE;
+    nodePoolFree = 0;
+    pthread_mutex_unlock(&nodePoolLock);
 }
 void mergePokedexMenu() {
     // Check if there are enough owners to merge
     if (!ownerHead || ownerHead->next == ownerHead) {
-        printf("Not enough owners to merge.\n");
+        outPrintf("Not enough owners to merge.\n");
         return;
     }
 
-    printf("\n=== Merge Pokedexes ===\n");
+    outPrintf("\n=== Merge Pokedexes ===\n");
 
     // Always ask for both names first
-    printf("Enter name of first owner: ");
-    char *firstOwnerName = getDynamicInput();
+    char firstOwnerName[OWNER_NAME_BUFFER_SIZE];
+    char secondOwnerName[OWNER_NAME_BUFFER_SIZE];
+    outPrintf("Enter name of first owner: ");
+    int firstFits = readOwnerName(firstOwnerName);
 
-    printf("Enter name of second owner: ");
-    char *secondOwnerName = getDynamicInput();
+    outPrintf("Enter name of second owner: ");
+    int secondFits = readOwnerName(secondOwnerName);
 
-    OwnerNode *firstOwner = findOwnerByName(firstOwnerName);
-    OwnerNode *secondOwner = findOwnerByName(secondOwnerName);
+    unsigned long epoch = ringReadBegin();
+    OwnerNode *firstOwner = firstFits ? findOwnerByName(firstOwnerName) : NULL;
+    OwnerNode *secondOwner = secondFits ? findOwnerByName(secondOwnerName) : NULL;
 
     // Handle not found
     if (!firstOwner || !secondOwner) {
-        printf("One or both owners not found.\n");
-        free(firstOwnerName);
-        free(secondOwnerName);
+        outPrintf("One or both owners not found.\n");
+        ringReadEnd(epoch);
         return;
     }
 
-    printf("Merging %s and %s...\n", firstOwnerName, secondOwnerName);
+    outPrintf("Merging %s and %s...\n", firstOwnerName, secondOwnerName);
 
     // Merge the second owner's Pokedex into the first owner's
-    mergePokedexes(firstOwner->pokedexRoot, secondOwner->pokedexRoot);
+    lockOwnerPair(firstOwner, secondOwner);
+    PokemonNode *before = sharePokemonTree(firstOwner->pokedexRoot);
+    mergePokedexes(firstOwner, secondOwner);
+    undoRecordRoot(firstOwner, before);
+    unlockOwnerPair(firstOwner, secondOwner);
 
     // Remove the second owner from the list
     removeOwnerFromCircularList(secondOwner);
+    undoCommit("Merge Pokedexes");
+    ringReadEnd(epoch);
 
-    printf("Merge completed.\nOwner '%s' has been removed after merging.\n", secondOwnerName);
-
-    free(firstOwnerName);
-    free(secondOwnerName);
+    outPrintf("Merge completed.\nOwner '%s' has been removed after merging.\n", secondOwnerName);
 }
 
 /**
- * @brief Merges the second BST into the first BST.
- * @param firstRoot Pointer to the root of the first owner's BST
- * @param secondRoot Pointer to the root of the second owner's BST
+ * @brief Merges the second owner's BST into the first owner's BST.
+ * @param first Owner receiving the Pokemon
+ * @param second Owner being copied from
  */
-void mergePokedexes(PokemonNode *firstRoot, PokemonNode *secondRoot) {
-    if (!secondRoot) return;
+void mergePokedexes(OwnerNode *first, OwnerNode *second) {
+    TRACE_SPAN();
+    if (!first || !second || !second->pokedexRoot) return;
 
     // Perform BFS on the second BST
     NodeArray nodes;
     initNodeArray(&nodes, INITIAL_NODE_ARRAY_CAPACITY);
-    collectAll(secondRoot, &nodes);
+    collectAll(second->pokedexRoot, &nodes);
 
+    thawPokedex(first);
     for (int i = 0; i < nodes.size; i++) {
-        PokemonNode *newNode = createPokemonNode(nodes.nodes[i]->data);
-        firstRoot = insertPokemonNode(firstRoot, newNode);
+        PokemonNode *newNode = createPokemonNode(pokemonData(nodes.nodes[i]));
+        first->pokedexRoot = insertPokemonNode(first->pokedexRoot, newNode);
+        indexPokemonAdded(first, pokemonID(nodes.nodes[i]));
     }
 
     free(nodes.nodes); // Free the dynamic array used for BFS
@@ -937,20 +1586,70 @@ void mergePokedexes(PokemonNode *firstRoot, PokemonNode *secondRoot) {
 void removeOwnerFromCircularList(OwnerNode *target) {
     if (!target) return;
 
+    pthread_mutex_lock(&ownerRingLock);
+    // Someone else already unlinked it
+    if (target->isRetired) {
+        pthread_mutex_unlock(&ownerRingLock);
+        return;
+    }
+
+    // the undo log keeps the owner alive until the change can't come back
+    undoRecordUnlinked(target, target->prev, target == ownerHead);
+    unlinkOwnerLocked(target);
+    reclaimRetiredOwners();
+    pthread_mutex_unlock(&ownerRingLock);
+}
+
+// func that takes an owner out of the ring but leaves it allocated
+void unlinkOwnerLocked(OwnerNode *target) {
     // If the list has only one owner
     if (target->next == target && target->prev == target) {
-        ownerHead = NULL;
+        __atomic_store_n(&ownerHead, NULL, __ATOMIC_RELEASE);
     } else {
-        // Update the neighbors to skip the target
-        target->prev->next = target->next;
-        target->next->prev = target->prev;
+        // Update the neighbors to skip the target; target keeps its own links
+        // so a reader standing on it can still walk on
+        __atomic_store_n(&target->prev->next, target->next, __ATOMIC_RELEASE);
+        __atomic_store_n(&target->next->prev, target->prev, __ATOMIC_RELEASE);
 
         if (target == ownerHead) {
-            ownerHead = target->next; // Update head if necessary
+            __atomic_store_n(&ownerHead, target->next, __ATOMIC_RELEASE); // Update head if necessary
         }
     }
 
-    freeOwnerNode(target);
+    indexOwnerUnlinked(target);
+    nameTrieOwnerUnlinked(target);
+    directoryRemoveOwner(target);
+    target->isRetired = 1;
+}
+
+// func that puts an unlinked owner back after prev
+void relinkOwnerLocked(OwnerNode *owner, OwnerNode *prev, int makeHead) {
+    owner->isRetired = 0;
+    indexOwnerLinked(owner);
+    nameTrieOwnerLinked(owner);
+    directoryInsertOwner(owner);
+    linkOwnerInRingLocked(owner, prev, makeHead);
+}
+
+void linkOwnerInRingLocked(OwnerNode *owner, OwnerNode *prev, int makeHead) {
+    if (!ownerHead) {
+        owner->next = owner->prev = owner;
+        __atomic_store_n(&ownerHead, owner, __ATOMIC_RELEASE);
+        return;
+    }
+
+    if (ownerDirectoryMode) {
+        // sorted position: after the predecessor, or in front as the new head
+        prev = directoryPredecessor(owner);
+        makeHead = prev == NULL;
+    }
+    if (!prev || prev->isRetired) prev = ownerHead->prev;
+    // fill in the owner first, then publish it to readers
+    owner->prev = prev;
+    owner->next = prev->next;
+    __atomic_store_n(&prev->next, owner, __ATOMIC_RELEASE);
+    __atomic_store_n(&owner->next->prev, owner, __ATOMIC_RELEASE);
+    if (makeHead) __atomic_store_n(&ownerHead, owner, __ATOMIC_RELEASE);
 }
 
 /**
@@ -961,7 +1660,7 @@ void removeOwnerFromCircularList(OwnerNode *target) {
 void initNodeArray(NodeArray *na, int cap) {
     na->nodes = (PokemonNode **)malloc(sizeof(PokemonNode *) * cap);
     if (!na->nodes) {
-        printf("Memory allocation failed for NodeArray.\n");
+        outPrintf("Memory allocation failed for NodeArray.\n");
         exit(1);
     }
     na->size = 0;
@@ -981,7 +1680,7 @@ void collectAll(PokemonNode *root, NodeArray *na) {
         na->capacity *= 2;
         na->nodes = (PokemonNode **)realloc(na->nodes, sizeof(PokemonNode *) * na->capacity);
         if (!na->nodes) {
-            printf("Memory reallocation failed for NodeArray.\n");
+            outPrintf("Memory reallocation failed for NodeArray.\n");
             exit(1);
         }
     }
@@ -990,114 +1689,4220 @@ void collectAll(PokemonNode *root, NodeArray *na) {
     na->nodes[na->size++] = root;
 
     // Recurse left and right
-    collectAll(root->left, na);
-    collectAll(root->right, na);
+    collectAll(pokemonLeft(root), na);
+    collectAll(pokemonRight(root), na);
 }
 
 void sortOwners() {
+    TRACE_SPAN();
+    pthread_mutex_lock(&ownerRingLock);
     if (!ownerHead || ownerHead->next == ownerHead) {
         // No owners or only one owner in the list
-        printf("0 or 1 owners only => no need to sort.\n");
+        pthread_mutex_unlock(&ownerRingLock);
+        outPrintf("0 or 1 owners only => no need to sort.\n");
         return;
     }
 
-    int swapped;
-    OwnerNode *current;
-    OwnerNode *last = NULL;
-
-    // Bubble Sort for circular doubly linked list
-    do {
-        swapped = 0;
-        current = ownerHead;
-
-        while (current->next != last && current->next != ownerHead) {
-            if (strcmp(current->ownerName, current->next->ownerName) > 0) {
-                // Swap data between the two nodes
-                swapOwnerData(current, current->next);
-                swapped = 1;
-            }
-            current = current->next;
-        }
-        last = current;
-    } while (swapped);
+    // the directory's bottom level is already in name order: relink along it
+    // (readers may skip or repeat a node while this runs, but never touch
+    // freed memory)
+    pthread_rwlock_rdlock(&ownerDirectoryLock);
+    OwnerDirectoryNode *first = ownerDirectory->forward[0];
+    for (OwnerDirectoryNode *node = first; node; node = node->forward[0]) {
+        OwnerNode *next = node->forward[0] ? node->forward[0]->owner : first->owner;
+        __atomic_store_n(&node->owner->next, next, __ATOMIC_RELEASE);
+        __atomic_store_n(&next->prev, node->owner, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&ownerHead, first->owner, __ATOMIC_RELEASE);
+    pthread_rwlock_unlock(&ownerDirectoryLock);
+    pthread_mutex_unlock(&ownerRingLock);
 
-    printf("Owners sorted by name.\n");
+    outPrintf("Owners sorted by name.\n");
 }
 
-/**
- * @brief Swaps the data of two OwnerNodes.
- * @param a First OwnerNode
- * @param b Second OwnerNode
- */
-void swapOwnerData(OwnerNode *a, OwnerNode *b) {
-    if (!a || !b) return;
-
-    // Swap owner names
-    char *tempName = a->ownerName;
-    a->ownerName = b->ownerName;
-    b->ownerName = tempName;
-
-    // Swap Pokedex roots
-    PokemonNode *tempPokedex = a->pokedexRoot;
-    a->pokedexRoot = b->pokedexRoot;
-    b->pokedexRoot = tempPokedex;
+// does exactly what the func's name says :)
+int compareDirectoryOwners(const OwnerNode *a, const OwnerNode *b) {
+    int diff = strcmp(a->ownerName, b->ownerName);
+    if (diff) return diff;
+    return (a > b) - (a < b);
 }
 //print the circular owner list
 void printOwnersCircular() {
-    if (!ownerHead) {
-        printf("No owners.\n");
+    if (!getOwnerHead()) {
+        outPrintf("No owners.\n");
         return;
     }
 
     // Get the direction
-    printf("Enter direction (F or B): ");
+    outPrintf("Enter direction (F or B): ");
     char directionBuffer[DIRECTION_BUFFER_SIZE];
+    outFlush();
     fgets(directionBuffer, sizeof(directionBuffer), stdin);
     char direction = tolower(directionBuffer[0]); // Normalize to lowercase
 
     // Get the number of prints
     int times = readIntSafe("How many prints? ");
 
-    OwnerNode *current = ownerHead;
-    for (int i = 1; i <= times; i++) {
-        printf("[%d] %s\n", i, current->ownerName);
-
-        // Move in the chosen direction
-        if (direction == 'f') {
-            current = current->next;
-        } else if (direction == 'b') {
-            current = current->prev;
-        }
-    }
+    unsigned long epoch = ringReadBegin();
+    OwnerNode *head = getOwnerHead();
+    if (head) writeOwnerRing(head, direction, times);
+    ringReadEnd(epoch);
 }
-// func that frees all owners
-void freeAllOwners() {
-    if (!ownerHead) return;
 
-    OwnerNode *current = ownerHead;
+#define RING_PRINT_BUFFER_SIZE 65536
+// Room for "[", the line number, "] " and "\n"
+#define RING_PRINT_LINE_OVERHEAD 16
+
+// func that prints "[i] name" lines for times steps around the ring.
+// One walk caches the names in direction order; line i then uses name
+// (i - 1) % count, and the lines go out in large fwrite blocks.
+void writeOwnerRing(OwnerNode *head, char direction, int times) {
+    if (times < 1) return;
+
+    // snapshot the ring once; any other direction stays on the head
+    int count = 0, capacity = INITIAL_NODE_ARRAY_CAPACITY;
+    const char **names = (const char **)malloc(sizeof(char *) * capacity);
+    size_t *lengths = (size_t *)malloc(sizeof(size_t) * capacity);
+    char *buffer = (char *)malloc(RING_PRINT_BUFFER_SIZE);
+    if (!names || !lengths || !buffer) {
+        outPrintf("Memory allocation failed.\n");
+        exit(1);
+    }
+    OwnerNode *current = head;
     do {
-        OwnerNode *next = current->next;
-        freeOwnerNode(current);
-        current = next;
-    } while (current != ownerHead);
+        if (count == capacity) {
+            capacity *= 2;
+            names = (const char **)realloc(names, sizeof(char *) * capacity);
+            lengths = (size_t *)realloc(lengths, sizeof(size_t) * capacity);
+            if (!names || !lengths) {
+                outPrintf("Memory allocation failed.\n");
+                exit(1);
+            }
+        }
+        names[count] = current->ownerName;
+        lengths[count] = (size_t)current->nameLength;
+        count++;
+        if (direction == 'f')
+            current = ownerNext(current);
+        else if (direction == 'b')
+            current = ownerPrev(current);
+    } while (current != head && (direction == 'f' || direction == 'b'));
+
+    // line number kept as text and incremented in place
+    char number[RING_PRINT_LINE_OVERHEAD];
+    int numberStart = RING_PRINT_LINE_OVERHEAD - 1;
+    number[numberStart] = '1';
+
+    size_t used = 0;
+    int position = 0;
+    for (int i = 1; i <= times; i++) {
+        size_t length = lengths[position];
+        if (used + length + RING_PRINT_LINE_OVERHEAD > RING_PRINT_BUFFER_SIZE) {
+            outWrite(buffer, used);
+            used = 0;
+        }
+        if (length + RING_PRINT_LINE_OVERHEAD > RING_PRINT_BUFFER_SIZE) {
+            // a name bigger than the buffer goes out on its own
+            outPrintf("[%d] %s\n", i, names[position]);
+        } else {
+            int digits = RING_PRINT_LINE_OVERHEAD - numberStart;
+            buffer[used++] = '[';
+            memcpy(buffer + used, number + numberStart, digits);
+            used += digits;
+            buffer[used++] = ']';
+            buffer[used++] = ' ';
+            memcpy(buffer + used, names[position], length);
+            used += length;
+            buffer[used++] = '\n';
+        }
+
+        int digit = RING_PRINT_LINE_OVERHEAD - 1;
+        while (digit >= numberStart && number[digit] == '9')
+            number[digit--] = '0';
+        if (digit < numberStart)
+            number[--numberStart] = '1';
+        else
+            number[digit]++;
+
+        if (++position == count) position = 0;
+    }
+    outWrite(buffer, used);
+
+    free(names);
+    free(lengths);
+    free(buffer);
+}
+// func that frees all owners
+void freeAllOwners() {
+    pthread_mutex_lock(&ownerRingLock);
+    if (ownerHead) {
+        OwnerNode *current = ownerHead;
+        do {
+            OwnerNode *next = current->next;
+            freeOwnerNode(current);
+            current = next;
+        } while (current != ownerHead);
+
+        ownerHead = NULL;
+    }
+
+    // no readers are left at exit, so everything still retired can go too
+    while (retiredOwners) {
+        OwnerNode *next = retiredOwners->retireNext;
+        freeOwnerNode(retiredOwners);
+        retiredOwners = next;
+    }
+    pthread_mutex_unlock(&ownerRingLock);
+}
+
+// --------------------------------------------------------------
+// Concurrency: ring read sections, epoch reclamation, owner locks
+// --------------------------------------------------------------
+unsigned long ringReadBegin() {
+    for (;;) {
+        unsigned long epoch = __atomic_load_n(&ringEpoch, __ATOMIC_ACQUIRE);
+        __atomic_add_fetch(&ringReaders[epoch % RING_EPOCH_SLOTS], 1, __ATOMIC_SEQ_CST);
+        // if the epoch moved on before we registered, retry in the new one
+        if (__atomic_load_n(&ringEpoch, __ATOMIC_SEQ_CST) == epoch)
+            return epoch;
+        __atomic_sub_fetch(&ringReaders[epoch % RING_EPOCH_SLOTS], 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void ringReadEnd(unsigned long epoch) {
+    __atomic_sub_fetch(&ringReaders[epoch % RING_EPOCH_SLOTS], 1, __ATOMIC_SEQ_CST);
+
+    // opportunistically free what the last reader was holding back
+    if (__atomic_load_n(&retiredOwners, __ATOMIC_ACQUIRE) &&
+        pthread_mutex_trylock(&ownerRingLock) == 0) {
+        reclaimRetiredOwners();
+        pthread_mutex_unlock(&ownerRingLock);
+    }
+}
+
+OwnerNode *ownerNext(OwnerNode *owner) {
+    return __atomic_load_n(&owner->next, __ATOMIC_ACQUIRE);
+}
+
+OwnerNode *ownerPrev(OwnerNode *owner) {
+    return __atomic_load_n(&owner->prev, __ATOMIC_ACQUIRE);
+}
+
+OwnerNode *getOwnerHead() {
+    return __atomic_load_n(&ownerHead, __ATOMIC_ACQUIRE);
+}
+
+int countLinkedOwners() {
+    OwnerNode *head = getOwnerHead();
+    if (!head) return 0;
+    int count = 0;
+    OwnerNode *cur = head;
+    do {
+        count++;
+        cur = ownerNext(cur);
+    } while (cur != head);
+    return count;
+}
+
+void pinOwner(OwnerNode *owner) {
+    __atomic_add_fetch(&owner->pinCount, 1, __ATOMIC_SEQ_CST);
+}
+
+void unpinOwner(OwnerNode *owner) {
+    if (owner) __atomic_sub_fetch(&owner->pinCount, 1, __ATOMIC_SEQ_CST);
+}
+
+OwnerNode *ownerAtPosition(int position) {
+    OwnerNode *head = getOwnerHead();
+    if (!head || position < 1) return NULL;
+    OwnerNode *owner = head;
+    for (int i = 1; i < position; i++) {
+        owner = ownerNext(owner);
+        if (owner == head) return NULL;
+    }
+    return owner;
+}
+
+OwnerNode *findAndPinOwner(const char *name) {
+    unsigned long epoch = ringReadBegin();
+    OwnerNode *owner = findOwnerByName(name);
+    if (owner) pinOwner(owner);
+    ringReadEnd(epoch);
+    return owner;
+}
+
+void retireOwner(OwnerNode *owner) {
+    owner->isRetired = 1;
+    owner->retireEpoch = __atomic_load_n(&ringEpoch, __ATOMIC_SEQ_CST);
+    owner->retireNext = retiredOwners;
+    __atomic_store_n(&retiredOwners, owner, __ATOMIC_RELEASE);
+}
+
+void reclaimRetiredOwners() {
+    // The epoch may move from e to e+1 once nobody is left in e-1. An owner
+    // retired in epoch r is unreachable for everyone once the epoch is r+2.
+    for (int step = 0; step < RING_EPOCH_SLOTS - 1; step++) {
+        unsigned long epoch = __atomic_load_n(&ringEpoch, __ATOMIC_SEQ_CST);
+        int previousSlot = (int)((epoch + RING_EPOCH_SLOTS - 1) % RING_EPOCH_SLOTS);
+        if (__atomic_load_n(&ringReaders[previousSlot], __ATOMIC_SEQ_CST) != 0)
+            break;
+        __atomic_store_n(&ringEpoch, epoch + 1, __ATOMIC_SEQ_CST);
+    }
+
+    unsigned long epoch = __atomic_load_n(&ringEpoch, __ATOMIC_SEQ_CST);
+    OwnerNode **link = &retiredOwners;
+    while (*link) {
+        OwnerNode *owner = *link;
+        // a pin is taken inside a read section, so it is visible by now
+        if (owner->retireEpoch + 2 <= epoch && __atomic_load_n(&owner->pinCount, __ATOMIC_SEQ_CST) == 0) {
+            *link = owner->retireNext;
+            freeOwnerNode(owner);
+        } else {
+            link = &owner->retireNext;
+        }
+    }
+}
+
+void lockOwnerRead(OwnerNode *owner) {
+    pthread_rwlock_rdlock(&owner->lock);
+}
+
+void lockOwnerWrite(OwnerNode *owner) {
+    pthread_rwlock_wrlock(&owner->lock);
+}
+
+void unlockOwner(OwnerNode *owner) {
+    pthread_rwlock_unlock(&owner->lock);
+}
+
+void lockOwnerPair(OwnerNode *dest, OwnerNode *src) {
+    if (dest == src) {
+        lockOwnerWrite(dest);
+        return;
+    }
+    // always lock the lower address first
+    if (dest < src) {
+        lockOwnerWrite(dest);
+        lockOwnerRead(src);
+    } else {
+        lockOwnerRead(src);
+        lockOwnerWrite(dest);
+    }
+}
+
+void unlockOwnerPair(OwnerNode *dest, OwnerNode *src) {
+    unlockOwner(dest);
+    if (dest != src)
+        unlockOwner(src);
+}
+// --------------------------------------------------------------
+// Work-stealing task pool
+// --------------------------------------------------------------
+
+// index of the calling thread's deque, -1 outside the pool
+__thread int currentWorkerIndex = -1;
+
+// take the newest task from our own deque
+int popLocalTask(TaskDeque *deque, Task *out) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->size > 0) {
+        deque->size--;
+        *out = deque->tasks[(deque->head + deque->size) % deque->capacity];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// take the oldest task from someone else's deque
+int stealTask(TaskPool *pool, int self, Task *out) {
+    for (int i = 1; i <= pool->workerCount; i++) {
+        TaskDeque *victim = &pool->deques[(self + i) % pool->workerCount];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->size > 0) {
+            *out = victim->tasks[victim->head];
+            victim->head = (victim->head + 1) % victim->capacity;
+            victim->size--;
+            pthread_mutex_unlock(&victim->lock);
+            return 1;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return 0;
+}
+
+void *taskWorkerMain(void *arg) {
+    TaskPool *pool = taskPool;
+    int self = (int)(size_t)arg;
+    currentWorkerIndex = self;
+
+    for (;;) {
+        Task task;
+        if (popLocalTask(&pool->deques[self], &task) || stealTask(pool, self, &task)) {
+            pthread_mutex_lock(&pool->lock);
+            pool->queued--;
+            pthread_mutex_unlock(&pool->lock);
+
+            task.func(task.arg);
+
+            pthread_mutex_lock(&pool->lock);
+            if (--pool->pending == 0)
+                pthread_cond_broadcast(&pool->allDone);
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+
+        // nothing to run or steal: sleep until something is queued
+        pthread_mutex_lock(&pool->lock);
+        while (pool->queued == 0 && !pool->stopping)
+            pthread_cond_wait(&pool->workReady, &pool->lock);
+        int done = pool->stopping && pool->queued == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (done)
+            break;
+    }
+    return NULL;
+}
+
+TaskPool *getTaskPool() {
+    if (taskPool) return taskPool;
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cores < 1 ? 1 : (cores > MAX_POOL_WORKERS ? MAX_POOL_WORKERS : (int)cores);
+
+    TaskPool *pool = (TaskPool *)malloc(sizeof(TaskPool));
+    if (!pool) {
+        outPrintf("Memory allocation failed for TaskPool.\n");
+        exit(1);
+    }
+    pool->threads = (pthread_t *)malloc(sizeof(pthread_t) * workers);
+    pool->deques = (TaskDeque *)malloc(sizeof(TaskDeque) * workers);
+    if (!pool->threads || !pool->deques) {
+        outPrintf("Memory allocation failed for TaskPool.\n");
+        exit(1);
+    }
+    pool->workerCount = workers;
+    pool->queued = pool->pending = pool->nextDeque = pool->stopping = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workReady, NULL);
+    pthread_cond_init(&pool->allDone, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        TaskDeque *deque = &pool->deques[i];
+        deque->capacity = INITIAL_NODE_ARRAY_CAPACITY;
+        deque->tasks = (Task *)malloc(sizeof(Task) * deque->capacity);
+        if (!deque->tasks) {
+            outPrintf("Memory allocation failed for TaskDeque.\n");
+            exit(1);
+        }
+        deque->head = deque->size = 0;
+        pthread_mutex_init(&deque->lock, NULL);
+    }
+
+    taskPool = pool;
+    for (int i = 0; i < workers; i++)
+        pthread_create(&pool->threads[i], NULL, taskWorkerMain, (void *)(size_t)i);
+    return pool;
+}
+
+void submitTask(TaskPool *pool, TaskFunc func, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->pending++;
+    int target = currentWorkerIndex;
+    if (target < 0)
+        target = pool->nextDeque++ % pool->workerCount;
+    pthread_mutex_unlock(&pool->lock);
+
+    TaskDeque *deque = &pool->deques[target];
+    pthread_mutex_lock(&deque->lock);
+    if (deque->size == deque->capacity) {
+        // unroll the circular buffer into a bigger one
+        Task *bigger = (Task *)malloc(sizeof(Task) * deque->capacity * 2);
+        if (!bigger) {
+            outPrintf("Memory allocation failed for TaskDeque.\n");
+            exit(1);
+        }
+        for (int i = 0; i < deque->size; i++)
+            bigger[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        free(deque->tasks);
+        deque->tasks = bigger;
+        deque->head = 0;
+        deque->capacity *= 2;
+    }
+    deque->tasks[(deque->head + deque->size) % deque->capacity].func = func;
+    deque->tasks[(deque->head + deque->size) % deque->capacity].arg = arg;
+    deque->size++;
+    pthread_mutex_unlock(&deque->lock);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->queued++;
+    pthread_cond_signal(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void waitTaskPool(TaskPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->allDone, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void destroyTaskPool() {
+    TaskPool *pool = taskPool;
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->workerCount; i++)
+        pthread_join(pool->threads[i], NULL);
+    for (int i = 0; i < pool->workerCount; i++) {
+        free(pool->deques[i].tasks);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->workReady);
+    pthread_cond_destroy(&pool->allDone);
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+    taskPool = NULL;
+}
+
+// --------------------------------------------------------------
+// Merge many owners: flatten, k-way merge, rebuild, retire
+// --------------------------------------------------------------
+
+void collectInOrder(PokemonNode *root, NodeArray *na) {
+    if (!root) return;
+
+    collectInOrder(pokemonLeft(root), na);
+    addNode(na, root);
+    collectInOrder(pokemonRight(root), na);
+}
+
+typedef struct
+{
+    PokemonNode *root;
+    NodeArray *run;
+} FlattenTask;
+
+void flattenTaskMain(void *arg) {
+    FlattenTask *task = (FlattenTask *)arg;
+    collectInOrder(task->root, task->run);
+}
+
+// first index in run whose ID is >= id
+int lowerBoundRun(const NodeArray *run, int id) {
+    int lo = 0, hi = run->size;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (pokemonID(run->nodes[mid]) < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+typedef struct
+{
+    NodeArray *runs;
+    int runCount;
+    int lowID;  // inclusive
+    int highID; // exclusive
+    NodeArray out;
+} MergeRangeTask;
+
+// k-way merge of the part of every run that falls in [lowID, highID)
+void mergeRangeTaskMain(void *arg) {
+    MergeRangeTask *task = (MergeRangeTask *)arg;
+    int *pos = (int *)malloc(sizeof(int) * task->runCount);
+    int *end = (int *)malloc(sizeof(int) * task->runCount);
+    int *heap = (int *)malloc(sizeof(int) * task->runCount); // min-heap of run indexes
+    if (!pos || !end || !heap) {
+        outPrintf("Memory allocation failed for merge.\n");
+        exit(1);
+    }
+
+    int heapSize = 0;
+    for (int r = 0; r < task->runCount; r++) {
+        pos[r] = lowerBoundRun(&task->runs[r], task->lowID);
+        end[r] = lowerBoundRun(&task->runs[r], task->highID);
+        if (pos[r] < end[r])
+            heap[heapSize++] = r;
+    }
+
+#define RUN_HEAD_ID(r) (pokemonID(task->runs[(r)].nodes[pos[(r)]]))
+    // heapify
+    for (int i = heapSize / 2 - 1; i >= 0; i--) {
+        int at = i;
+        for (;;) {
+            int smallest = at, l = 2 * at + 1, r = l + 1;
+            if (l < heapSize && RUN_HEAD_ID(heap[l]) < RUN_HEAD_ID(heap[smallest])) smallest = l;
+            if (r < heapSize && RUN_HEAD_ID(heap[r]) < RUN_HEAD_ID(heap[smallest])) smallest = r;
+            if (smallest == at) break;
+            int tmp = heap[at]; heap[at] = heap[smallest]; heap[smallest] = tmp;
+            at = smallest;
+        }
+    }
+
+    int lastID = task->lowID - 1;
+    while (heapSize > 0) {
+        int r = heap[0];
+        PokemonNode *node = task->runs[r].nodes[pos[r]++];
+        // the same species can come from several owners; keep the first
+        if (pokemonID(node) != lastID) {
+            addNode(&task->out, node);
+            lastID = pokemonID(node);
+        }
+        if (pos[r] == end[r])
+            heap[0] = heap[--heapSize];
+
+        int at = 0;
+        for (;;) {
+            int smallest = at, l = 2 * at + 1, rr = l + 1;
+            if (l < heapSize && RUN_HEAD_ID(heap[l]) < RUN_HEAD_ID(heap[smallest])) smallest = l;
+            if (rr < heapSize && RUN_HEAD_ID(heap[rr]) < RUN_HEAD_ID(heap[smallest])) smallest = rr;
+            if (smallest == at) break;
+            int tmp = heap[at]; heap[at] = heap[smallest]; heap[smallest] = tmp;
+            at = smallest;
+        }
+    }
+#undef RUN_HEAD_ID
+
+    free(pos);
+    free(end);
+    free(heap);
+}
+
+void parallelMergeRuns(NodeArray *runs, int runCount, NodeArray *merged) {
+    int minID = 0, maxID = -1;
+    for (int r = 0; r < runCount; r++) {
+        if (runs[r].size == 0) continue;
+        int first = pokemonID(runs[r].nodes[0]);
+        int last = pokemonID(runs[r].nodes[runs[r].size - 1]);
+        if (maxID < minID) {
+            minID = first;
+            maxID = last;
+        } else {
+            if (first < minID) minID = first;
+            if (last > maxID) maxID = last;
+        }
+    }
+    if (maxID < minID) return; // every run is empty
+
+    TaskPool *pool = getTaskPool();
+    int span = maxID - minID + 1;
+    int rangeCount = pool->workerCount < span ? pool->workerCount : span;
+    MergeRangeTask *ranges = (MergeRangeTask *)malloc(sizeof(MergeRangeTask) * rangeCount);
+    if (!ranges) {
+        outPrintf("Memory allocation failed for merge.\n");
+        exit(1);
+    }
+
+    // split the ID space into equal slices, one k-way merge per slice
+    for (int i = 0; i < rangeCount; i++) {
+        ranges[i].runs = runs;
+        ranges[i].runCount = runCount;
+        ranges[i].lowID = minID + (int)((long)span * i / rangeCount);
+        ranges[i].highID = minID + (int)((long)span * (i + 1) / rangeCount);
+        initNodeArray(&ranges[i].out, INITIAL_NODE_ARRAY_CAPACITY);
+        submitTask(pool, mergeRangeTaskMain, &ranges[i]);
+    }
+    waitTaskPool(pool);
+
+    // slices are disjoint and ordered, so concatenating keeps the result sorted
+    for (int i = 0; i < rangeCount; i++) {
+        for (int j = 0; j < ranges[i].out.size; j++)
+            addNode(merged, ranges[i].out.nodes[j]);
+        free(ranges[i].out.nodes);
+    }
+    free(ranges);
+}
+
+// sequential balanced build of sorted->nodes[lo, hi)
+PokemonNode *buildBalancedTree(NodeArray *sorted, int lo, int hi) {
+    if (lo >= hi) return NULL;
+
+    int mid = lo + (hi - lo) / 2;
+    PokemonNode *node = createPokemonNode(pokemonData(sorted->nodes[mid]));
+    if (!node) return NULL;
+    setPokemonLeft(node, buildBalancedTree(sorted, lo, mid));
+    setPokemonRight(node, buildBalancedTree(sorted, mid + 1, hi));
+    updatePokemonSummary(node);
+    return node;
+}
+
+// fix summaries of the nodes buildTaskMain created before their children existed
+void updateSplitSummaries(PokemonNode *node, int lo, int hi) {
+    if (!node || hi - lo <= PARALLEL_BUILD_CUTOFF) return;
+
+    int mid = lo + (hi - lo) / 2;
+    updateSplitSummaries(pokemonLeft(node), lo, mid);
+    updateSplitSummaries(pokemonRight(node), mid + 1, hi);
+    updatePokemonSummary(node);
+}
+
+typedef struct
+{
+    NodeArray *sorted;
+    int lo;
+    int hi;
+    PokemonNode *parent; // the finished subtree becomes a child of parent,
+    int isRight;         // on this side,
+    PokemonNode **root;  // or *root when parent is NULL
+} BuildTask;
+
+void storeBuiltSubtree(BuildTask *task, PokemonNode *subtree) {
+    if (!task->parent)
+        *task->root = subtree;
+    else if (task->isRight)
+        setPokemonRight(task->parent, subtree);
+    else
+        setPokemonLeft(task->parent, subtree);
+}
+
+void buildTaskMain(void *arg) {
+    BuildTask *task = (BuildTask *)arg;
+
+    if (task->hi - task->lo <= PARALLEL_BUILD_CUTOFF) {
+        storeBuiltSubtree(task, buildBalancedTree(task->sorted, task->lo, task->hi));
+        free(task);
+        return;
+    }
+
+    // create the middle node, then hand both halves to the pool
+    int mid = task->lo + (task->hi - task->lo) / 2;
+    PokemonNode *node = createPokemonNode(pokemonData(task->sorted->nodes[mid]));
+    storeBuiltSubtree(task, node);
+    if (node) {
+        BuildTask *left = (BuildTask *)malloc(sizeof(BuildTask));
+        BuildTask *right = (BuildTask *)malloc(sizeof(BuildTask));
+        if (!left || !right) {
+            outPrintf("Memory allocation failed for merge.\n");
+            exit(1);
+        }
+        *left = *task;
+        left->hi = mid;
+        left->parent = node;
+        left->isRight = 0;
+        *right = *task;
+        right->lo = mid + 1;
+        right->parent = node;
+        right->isRight = 1;
+        submitTask(taskPool, buildTaskMain, left);
+        submitTask(taskPool, buildTaskMain, right);
+    }
+    free(task);
+}
+
+PokemonNode *parallelBuildTree(NodeArray *sorted) {
+    if (sorted->size <= PARALLEL_BUILD_CUTOFF)
+        return buildBalancedTree(sorted, 0, sorted->size);
+
+    PokemonNode *root = NULL;
+    BuildTask *task = (BuildTask *)malloc(sizeof(BuildTask));
+    if (!task) {
+        outPrintf("Memory allocation failed for merge.\n");
+        exit(1);
+    }
+    task->sorted = sorted;
+    task->lo = 0;
+    task->hi = sorted->size;
+    task->parent = NULL;
+    task->isRight = 0;
+    task->root = &root;
+
+    TaskPool *pool = getTaskPool();
+    submitTask(pool, buildTaskMain, task);
+    waitTaskPool(pool);
+    updateSplitSummaries(root, 0, sorted->size);
+    return root;
+}
+
+void removeOwnersFromCircularList(OwnerNode **owners, int count) {
+    pthread_mutex_lock(&ownerRingLock);
+    for (int i = 0; i < count; i++) {
+        OwnerNode *target = owners[i];
+        if (!target || target->isRetired) continue;
+
+        undoRecordUnlinked(target, target->prev, target == ownerHead);
+        unlinkOwnerLocked(target);
+    }
+    // one reclamation pass for the whole batch
+    reclaimRetiredOwners();
+    pthread_mutex_unlock(&ownerRingLock);
+}
+
+// order owners by address so every multi-owner operation locks in the same order
+int compareOwnerAddress(const void *a, const void *b) {
+    OwnerNode *ownerA = *(OwnerNode **)a;
+    OwnerNode *ownerB = *(OwnerNode **)b;
+    return (ownerA > ownerB) - (ownerA < ownerB);
+}
+
+void mergeManyPokedexesMenu() {
+    // owners are pinned between prompts instead of holding a read section open
+    unsigned long epoch = ringReadBegin();
+    int linked = countLinkedOwners();
+    ringReadEnd(epoch);
+    if (linked < 2) {
+        outPrintf("Not enough owners to merge.\n");
+        return;
+    }
+
+    outPrintf("\n=== Merge Many Pokedexes ===\n");
+    outPrintf("Enter name of destination owner: ");
+    char name[OWNER_NAME_BUFFER_SIZE];
+    OwnerNode *dest = readOwnerName(name) ? findAndPinOwner(name) : NULL;
+    if (!dest) {
+        outPrintf("Owner not found.\n");
+        return;
+    }
+
+    // every source is a distinct owner other than the destination
+    int count = readIntSafe("How many owners to merge into it? ");
+    if (count < 1 || count > linked - 1) {
+        outPrintf("Invalid choice.\n");
+        unpinOwner(dest);
+        return;
+    }
+
+    // owners[0] is the destination, the rest are sources
+    OwnerNode **owners = (OwnerNode **)malloc(sizeof(OwnerNode *) * (count + 1));
+    if (!owners) {
+        outPrintf("Memory allocation failed for merge.\n");
+        unpinOwner(dest);
+        return;
+    }
+    owners[0] = dest;
+    int total = 1;
+    for (int i = 0; i < count; i++) {
+        outPrintf("Enter name of owner #%d: ", i + 1);
+        OwnerNode *source = readOwnerName(name) ? findAndPinOwner(name) : NULL;
+        int duplicate = 0;
+        for (int j = 0; source && j < total; j++)
+            if (owners[j] == source) duplicate = 1;
+
+        if (!source) {
+            outPrintf("Owner '%s' not found, skipping.\n", name);
+        } else if (duplicate) {
+            outPrintf("Owner '%s' already listed, skipping.\n", name);
+            unpinOwner(source);
+        } else {
+            owners[total++] = source;
+        }
+    }
+
+    if (total == 1) {
+        outPrintf("Nothing to merge.\n");
+        unpinOwner(dest);
+        free(owners);
+        return;
+    }
+
+    outPrintf("Merging %d owners into %s...\n", total - 1, dest->ownerName);
+
+    // lock every involved owner in address order
+    OwnerNode **lockOrder = (OwnerNode **)malloc(sizeof(OwnerNode *) * total);
+    NodeArray *runs = (NodeArray *)malloc(sizeof(NodeArray) * total);
+    FlattenTask *flatten = (FlattenTask *)malloc(sizeof(FlattenTask) * total);
+    if (!lockOrder || !runs || !flatten) {
+        outPrintf("Memory allocation failed for merge.\n");
+        exit(1);
+    }
+    memcpy(lockOrder, owners, sizeof(OwnerNode *) * total);
+    qsort(lockOrder, total, sizeof(OwnerNode *), compareOwnerAddress);
+    for (int i = 0; i < total; i++) {
+        if (lockOrder[i] == dest)
+            lockOwnerWrite(lockOrder[i]);
+        else
+            lockOwnerRead(lockOrder[i]);
+    }
+
+    // 1) flatten every tree to a sorted run, one task per owner
+    TaskPool *pool = getTaskPool();
+    for (int i = 0; i < total; i++) {
+        initNodeArray(&runs[i], INITIAL_NODE_ARRAY_CAPACITY);
+        flatten[i].root = owners[i]->pokedexRoot;
+        flatten[i].run = &runs[i];
+        submitTask(pool, flattenTaskMain, &flatten[i]);
+    }
+    waitTaskPool(pool);
+
+    // 2) k-way merge with deduplication, 3) rebuild the destination tree
+    NodeArray merged;
+    initNodeArray(&merged, INITIAL_NODE_ARRAY_CAPACITY);
+    parallelMergeRuns(runs, total, &merged);
+    PokemonNode *newRoot = parallelBuildTree(&merged);
+
+    // merged still points into the old trees, so index before freeing them
+    for (int i = 0; i < merged.size; i++)
+        indexPokemonAdded(dest, pokemonID(merged.nodes[i]));
+    PokemonNode *before = sharePokemonTree(dest->pokedexRoot);
+    thawPokedex(dest);
+    freePokemonTree(dest->pokedexRoot);
+    dest->pokedexRoot = newRoot;
+    undoRecordRoot(dest, before);
+
+    for (int i = total - 1; i >= 0; i--)
+        unlockOwner(lockOrder[i]);
+
+    // 4) unlink all sources in one batch; the undo log keeps them
+    removeOwnersFromCircularList(owners + 1, total - 1);
+    undoCommit("Merge Many Pokedexes");
+
+    outPrintf("Merge completed. %s now has %d Pokemon.\n", dest->ownerName, merged.size);
+    for (int i = 0; i < total; i++)
+        unpinOwner(owners[i]);
+
+    for (int i = 0; i < total; i++)
+        free(runs[i].nodes);
+    free(merged.nodes);
+    free(runs);
+    free(flatten);
+    free(lockOrder);
+    free(owners);
+}
+
+// --------------------------------------------------------------
+// Species -> owners index
+// --------------------------------------------------------------
+
+// grow every bitset so slot fits (caller holds speciesIndexLock for writing)
+void ensureOwnerSlotCapacity(int slot) {
+    int neededWords = slot / BITS_PER_WORD + 1;
+    if (!speciesOwnerBits) {
+        speciesOwnerBits = (unsigned long **)calloc(speciesCount, sizeof(unsigned long *));
+        if (!speciesOwnerBits) {
+            outPrintf("Memory allocation failed for species index.\n");
+            exit(1);
+        }
+    }
+    if (neededWords <= speciesOwnerWords) return;
+
+    int newWords = speciesOwnerWords ? speciesOwnerWords * 2 : 1;
+    while (newWords < neededWords) newWords *= 2;
+    for (int s = 0; s < speciesCount; s++) {
+        unsigned long *bits = (unsigned long *)realloc(speciesOwnerBits[s], sizeof(unsigned long) * newWords);
+        if (!bits) {
+            outPrintf("Memory reallocation failed for species index.\n");
+            exit(1);
+        }
+        memset(bits + speciesOwnerWords, 0, sizeof(unsigned long) * (newWords - speciesOwnerWords));
+        speciesOwnerBits[s] = bits;
+    }
+    OwnerNode **slots = (OwnerNode **)realloc(ownerSlots, sizeof(OwnerNode *) * newWords * BITS_PER_WORD);
+    if (!slots) {
+        outPrintf("Memory reallocation failed for species index.\n");
+        exit(1);
+    }
+    ownerSlots = slots;
+    speciesOwnerWords = newWords;
+}
+
+// returns 1 when the bit actually changed
+int setSpeciesBit(int id, int slot, int value) {
+    if (id < 1 || id > speciesCount || slot < 0) return 0;
+    unsigned long mask = 1UL << (slot % BITS_PER_WORD);
+    unsigned long *word = &speciesOwnerBits[id - 1][slot / BITS_PER_WORD];
+    int wasSet = (*word & mask) != 0;
+    if (value)
+        *word |= mask;
+    else
+        *word &= ~mask;
+    return wasSet != (value != 0);
+}
+
+// func that moves one species in or out of an owner's and the ring's totals;
+// returns 1 when the owner's bit actually changed
+int aggregateSpeciesChange(OwnerNode *owner, int id, int value) {
+    if (!setSpeciesBit(id, owner->ownerSlot, value)) return 0;
+    const PokemonData *species = getSpeciesByID(id);
+    updateAggregates(&owner->totals, species, value ? 1 : -1);
+    updateAggregates(&ringTotals, species, value ? 1 : -1);
+    return 1;
+}
+
+// visitor for indexOwnerLinked
+int indexSpeciesOfNode(PokemonNode *node, void *ctx) {
+    aggregateSpeciesChange((OwnerNode *)ctx, pokemonID(node), 1);
+    return 1;
+}
+
+// func that gives an owner the lowest free slot with empty totals
+// (caller holds speciesIndexLock for writing)
+void claimOwnerSlot(OwnerNode *owner) {
+    int slot = 0;
+    while (slot < ownerSlotCount && ownerSlots[slot]) slot++;
+    ensureOwnerSlotCapacity(slot);
+    if (slot == ownerSlotCount) ownerSlotCount++;
+    ownerSlots[slot] = owner;
+    owner->ownerSlot = slot;
+    memset(&owner->totals, 0, sizeof(owner->totals));
+}
+
+void indexOwnerLinked(OwnerNode *owner) {
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    claimOwnerSlot(owner);
+    traverseWithContext(owner->pokedexRoot, ORDER_PRE, indexSpeciesOfNode, owner);
+    pthread_rwlock_unlock(&speciesIndexLock);
+}
+
+void indexOwnerCloned(OwnerNode *owner, OwnerNode *source) {
+    // the source's read lock keeps its bits in step with the root we share
+    lockOwnerRead(source);
+    if (source->ownerSlot < 0 || source->pokedexRoot != owner->pokedexRoot) {
+        unlockOwner(source);
+        indexOwnerLinked(owner);
+        return;
+    }
+
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    claimOwnerSlot(owner);
+    unsigned long sourceMask = 1UL << (source->ownerSlot % BITS_PER_WORD);
+    int sourceWord = source->ownerSlot / BITS_PER_WORD;
+    unsigned long mask = 1UL << (owner->ownerSlot % BITS_PER_WORD);
+    int word = owner->ownerSlot / BITS_PER_WORD;
+    for (int s = 0; s < speciesCount; s++)
+        if (speciesOwnerBits[s][sourceWord] & sourceMask)
+            speciesOwnerBits[s][word] |= mask;
+    // same species, same totals; the ring gains a second copy of them
+    owner->totals = source->totals;
+    ringTotals.count += owner->totals.count;
+    ringTotals.hpSum += owner->totals.hpSum;
+    ringTotals.attackSum += owner->totals.attackSum;
+    for (int t = 0; t < POKEMON_TYPE_COUNT; t++)
+        ringTotals.typeCounts[t] += owner->totals.typeCounts[t];
+    pthread_rwlock_unlock(&speciesIndexLock);
+    unlockOwner(source);
+}
+
+void indexOwnerUnlinked(OwnerNode *owner) {
+    if (owner->ownerSlot < 0) return;
+
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    // clearing one bit per species is cheaper than walking the tree
+    for (int id = 1; id <= speciesCount; id++)
+        setSpeciesBit(id, owner->ownerSlot, 0);
+    // the owner's totals leave the ring with it
+    ringTotals.count -= owner->totals.count;
+    ringTotals.hpSum -= owner->totals.hpSum;
+    ringTotals.attackSum -= owner->totals.attackSum;
+    for (int t = 0; t < POKEMON_TYPE_COUNT; t++)
+        ringTotals.typeCounts[t] -= owner->totals.typeCounts[t];
+    ownerSlots[owner->ownerSlot] = NULL;
+    owner->ownerSlot = -1;
+    pthread_rwlock_unlock(&speciesIndexLock);
+}
+
+void indexPokemonAdded(OwnerNode *owner, int id) {
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    if (aggregateSpeciesChange(owner, id, 1))
+        undoStageIndexChange(owner, id);
+    pthread_rwlock_unlock(&speciesIndexLock);
+}
+
+void indexPokemonRemoved(OwnerNode *owner, int id) {
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    if (aggregateSpeciesChange(owner, id, 0))
+        undoStageIndexChange(owner, -id);
+    pthread_rwlock_unlock(&speciesIndexLock);
+}
+
+int findSpeciesOwners(const int *ids, int idCount, OwnerNode ***out) {
+    *out = NULL;
+    if (idCount < 1) return 0;
+    for (int i = 0; i < idCount; i++)
+        if (ids[i] < 1 || ids[i] > speciesCount) return 0;
+
+    pthread_rwlock_rdlock(&speciesIndexLock);
+    int found = 0;
+    OwnerNode **owners = NULL;
+    if (speciesOwnerWords > 0) {
+        owners = (OwnerNode **)malloc(sizeof(OwnerNode *) * ownerSlotCount);
+        if (!owners) {
+            pthread_rwlock_unlock(&speciesIndexLock);
+            outPrintf("Memory allocation failed for species lookup.\n");
+            return 0;
+        }
+        for (int w = 0; w < speciesOwnerWords; w++) {
+            unsigned long bits = ~0UL;
+            for (int i = 0; i < idCount; i++)
+                bits &= speciesOwnerBits[ids[i] - 1][w];
+            while (bits) {
+                int bit = __builtin_ctzl(bits);
+                owners[found++] = ownerSlots[w * BITS_PER_WORD + bit];
+                bits &= bits - 1;
+            }
+        }
+    }
+    pthread_rwlock_unlock(&speciesIndexLock);
+
+    if (found == 0) {
+        free(owners);
+        return 0;
+    }
+    *out = owners;
+    return found;
+}
+
+void freeSpeciesIndex() {
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    if (speciesOwnerBits) {
+        for (int s = 0; s < speciesCount; s++)
+            free(speciesOwnerBits[s]);
+        free(speciesOwnerBits);
+    }
+    free(ownerSlots);
+    free(speciesByScore);
+    speciesByScore = NULL;
+    speciesOwnerBits = NULL;
+    ownerSlots = NULL;
+    speciesOwnerWords = ownerSlotCount = 0;
+    pthread_rwlock_unlock(&speciesIndexLock);
+}
+
+void updateAggregates(PokedexAggregates *totals, const PokemonData *species, int sign) {
+    if (!species) return;
+    totals->count += sign;
+    totals->hpSum += sign * species->hp;
+    totals->attackSum += sign * species->attack;
+    totals->typeCounts[species->TYPE] += sign;
+}
+
+void printAggregates(const char *label, const PokedexAggregates *totals) {
+    if (totals->count == 0) {
+        outPrintf("%s: 0 Pokemon\n", label);
+        return;
+    }
+    outPrintf("%s: %d Pokemon, HP %lld (avg %.1f), Attack %lld (avg %.1f)\n", label, totals->count,
+              totals->hpSum, (double)totals->hpSum / totals->count,
+              totals->attackSum, (double)totals->attackSum / totals->count);
+    outPrintf("  Types:");
+    for (int t = 0; t < POKEMON_TYPE_COUNT; t++)
+        if (totals->typeCounts[t])
+            outPrintf(" %s %d", getTypeName((PokemonType)t), totals->typeCounts[t]);
+    outPrintf("\n");
+}
+
+void pokedexSummaryMenu() {
+    unsigned long epoch = ringReadBegin();
+    OwnerNode *head = getOwnerHead();
+    if (!head) {
+        outPrintf("No existing Pokedexes.\n");
+        ringReadEnd(epoch);
+        return;
+    }
+
+    // one pass over the ring; no tree is touched
+    pthread_rwlock_rdlock(&speciesIndexLock);
+    int owners = 0;
+    OwnerNode *current = head;
+    do {
+        printAggregates(current->ownerName, &current->totals);
+        owners++;
+        current = ownerNext(current);
+    } while (current != head);
+    PokedexAggregates all = ringTotals;
+    pthread_rwlock_unlock(&speciesIndexLock);
+
+    char label[INT_BUFFER];
+    snprintf(label, sizeof(label), "All %d owners", owners);
+    printAggregates(label, &all);
+    ringReadEnd(epoch);
+}
+
+void whoHasPokemonMenu() {
+    int idCount = readIntSafe("How many Pokemon IDs? ");
+    if (idCount < 1) {
+        outPrintf("Invalid choice.\n");
+        return;
+    }
+
+    int *ids = (int *)malloc(sizeof(int) * idCount);
+    if (!ids) {
+        outPrintf("Memory allocation failed.\n");
+        return;
+    }
+    for (int i = 0; i < idCount; i++) {
+        outPrintf("Enter Pokemon ID #%d: ", i + 1);
+        ids[i] = readPokemonIDSafe("");
+        if (ids[i] < 1 || ids[i] > speciesCount) {
+            outPrintf("Invalid ID.\n");
+            free(ids);
+            return;
+        }
+    }
+
+    // hold a read section so the owners we get back stay allocated while printing
+    unsigned long epoch = ringReadBegin();
+    OwnerNode **owners;
+    int found = findSpeciesOwners(ids, idCount, &owners);
+    if (idCount == 1)
+        outPrintf("Owners holding %s (ID %d): %d\n", getSpeciesByID(ids[0])->name, ids[0], found);
+    else
+        outPrintf("Owners holding all %d Pokemon: %d\n", idCount, found);
+    for (int i = 0; i < found; i++)
+        outPrintf("- %s\n", owners[i]->ownerName);
+    ringReadEnd(epoch);
+
+    free(owners);
+    free(ids);
+}
+
+// --------------------------------------------------------------
+// Leaderboards
+// --------------------------------------------------------------
+int pokemonScoreTenths(const PokemonData *data) {
+    return data->attack * 15 + data->hp * 12;
+}
+
+// heap item for the best-first search: a whole subtree or just its root
+typedef struct
+{
+    int key;
+    PokemonNode *node;
+    int subtree;
+} ScoreHeapItem;
+
+void scoreHeapPush(ScoreHeapItem *heap, int *size, ScoreHeapItem item) {
+    int at = (*size)++;
+    while (at > 0 && heap[(at - 1) / 2].key < item.key) {
+        heap[at] = heap[(at - 1) / 2];
+        at = (at - 1) / 2;
+    }
+    heap[at] = item;
+}
+
+ScoreHeapItem scoreHeapPop(ScoreHeapItem *heap, int *size) {
+    ScoreHeapItem top = heap[0];
+    ScoreHeapItem last = heap[--(*size)];
+    int at = 0;
+    for (;;) {
+        int child = 2 * at + 1;
+        if (child >= *size) break;
+        if (child + 1 < *size && heap[child + 1].key > heap[child].key) child++;
+        if (heap[child].key <= last.key) break;
+        heap[at] = heap[child];
+        at = child;
+    }
+    if (*size > 0) heap[at] = last;
+    return top;
+}
+
+// best score first, lower ID on ties
+int compareLeaderboardEntries(const void *a, const void *b) {
+    const LeaderboardEntry *entryA = (const LeaderboardEntry *)a;
+    const LeaderboardEntry *entryB = (const LeaderboardEntry *)b;
+    if (entryA->scoreTenths != entryB->scoreTenths)
+        return entryB->scoreTenths - entryA->scoreTenths;
+    return entryA->data->id - entryB->data->id;
+}
+
+int topPokemonOfOwner(PokemonNode *root, int k, LeaderboardEntry *out) {
+    if (!root || k < 1) return 0;
+
+    // the frontier stays O(k); start there and grow if a tie-heavy tree needs more
+    int capacity = 6 * k + 3;
+    ScoreHeapItem *heap = (ScoreHeapItem *)malloc(sizeof(ScoreHeapItem) * capacity);
+    if (!heap) {
+        outPrintf("Memory allocation failed for leaderboard.\n");
+        return 0;
+    }
+    int size = 0, found = 0;
+    ScoreHeapItem start = {pokemonSummary(root)->maxScore, root, 1};
+    scoreHeapPush(heap, &size, start);
+
+    while (size > 0 && found < k) {
+        ScoreHeapItem item = scoreHeapPop(heap, &size);
+        if (!item.subtree) {
+            out[found].data = pokemonData(item.node);
+            out[found].owner = NULL;
+            out[found].scoreTenths = item.key;
+            found++;
+            continue;
+        }
+        if (size + 3 > capacity) {
+            capacity *= 2;
+            ScoreHeapItem *bigger = (ScoreHeapItem *)realloc(heap, sizeof(ScoreHeapItem) * capacity);
+            if (!bigger) {
+                outPrintf("Memory reallocation failed for leaderboard.\n");
+                break;
+            }
+            heap = bigger;
+        }
+        ScoreHeapItem self = {pokemonScoreTenths(pokemonData(item.node)), item.node, 0};
+        scoreHeapPush(heap, &size, self);
+        PokemonNode *leftChild = pokemonLeft(item.node);
+        PokemonNode *rightChild = pokemonRight(item.node);
+        if (leftChild) {
+            ScoreHeapItem left = {pokemonSummary(leftChild)->maxScore, leftChild, 1};
+            scoreHeapPush(heap, &size, left);
+        }
+        if (rightChild) {
+            ScoreHeapItem right = {pokemonSummary(rightChild)->maxScore, rightChild, 1};
+            scoreHeapPush(heap, &size, right);
+        }
+    }
+    free(heap);
+
+    qsort(out, found, sizeof(LeaderboardEntry), compareLeaderboardEntries);
+    return found;
+}
+
+// a species with its precomputed score, for ordering the catalog
+typedef struct
+{
+    int scoreTenths;
+    int id;
+} SpeciesScore;
+
+int compareSpeciesScores(const void *a, const void *b) {
+    const SpeciesScore *speciesA = (const SpeciesScore *)a;
+    const SpeciesScore *speciesB = (const SpeciesScore *)b;
+    int diff = speciesB->scoreTenths - speciesA->scoreTenths;
+    return diff ? diff : speciesA->id - speciesB->id;
+}
+
+// sort the catalog by score, scoring every species in one column pass; the
+// first Global Top query after a catalog load pays for this, so it scores each
+// species once instead of twice per qsort comparison
+int *buildSpeciesByScore(const PokemonColumns *cols) {
+    int *order = (int *)malloc(sizeof(int) * cols->count);
+    int *scores = (int *)malloc(sizeof(int) * cols->count);
+    SpeciesScore *ranked = (SpeciesScore *)malloc(sizeof(SpeciesScore) * cols->count);
+    if (!order || !scores || !ranked) {
+        free(order);
+        free(scores);
+        free(ranked);
+        return NULL;
+    }
+
+    scoreColumns(cols, scores);
+    for (int i = 0; i < cols->count; i++) {
+        ranked[i].scoreTenths = scores[i];
+        ranked[i].id = cols->ids[i];
+    }
+    qsort(ranked, cols->count, sizeof(SpeciesScore), compareSpeciesScores);
+    for (int i = 0; i < cols->count; i++)
+        order[i] = ranked[i].id;
+    free(scores);
+    free(ranked);
+    return order;
+}
+
+int topPokemonGlobal(int k, LeaderboardEntry *out) {
+    if (k < 1) return 0;
+
+    const PokemonColumns *cols = getSpeciesColumns();
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    if (!speciesByScore && cols)
+        speciesByScore = buildSpeciesByScore(cols);
+    if (!speciesByScore) {
+        pthread_rwlock_unlock(&speciesIndexLock);
+        outPrintf("Memory allocation failed for leaderboard.\n");
+        return 0;
+    }
+    pthread_rwlock_unlock(&speciesIndexLock);
+
+    pthread_rwlock_rdlock(&speciesIndexLock);
+    int found = 0;
+    for (int i = 0; i < speciesCount && found < k && speciesOwnerWords > 0; i++) {
+        int id = speciesByScore[i];
+        for (int w = 0; w < speciesOwnerWords && found < k; w++) {
+            unsigned long bits = speciesOwnerBits[id - 1][w];
+            while (bits && found < k) {
+                int bit = __builtin_ctzl(bits);
+                out[found].data = &speciesCatalog[id - 1];
+                out[found].owner = ownerSlots[w * BITS_PER_WORD + bit];
+                out[found].scoreTenths = pokemonScoreTenths(&speciesCatalog[id - 1]);
+                found++;
+                bits &= bits - 1;
+            }
+        }
+    }
+    pthread_rwlock_unlock(&speciesIndexLock);
+    return found;
+}
+
+void ownerLeaderboardMenu(OwnerNode *owner) {
+    int k = readIntSafe("How many top Pokemon? ");
+    if (k < 1) {
+        outPrintf("Invalid choice.\n");
+        return;
+    }
+
+    lockOwnerRead(owner);
+    int total = pokemonTreeSize(owner->pokedexRoot);
+    if (k > total) k = total;
+    LeaderboardEntry *entries = (LeaderboardEntry *)malloc(sizeof(LeaderboardEntry) * (k > 0 ? k : 1));
+    if (!entries) {
+        unlockOwner(owner);
+        outPrintf("Memory allocation failed for leaderboard.\n");
+        return;
+    }
+    int found = topPokemonOfOwner(owner->pokedexRoot, k, entries);
+    if (found == 0)
+        outPrintf("Pokedex is empty.\n");
+    for (int i = 0; i < found; i++)
+        outPrintf("%d. %s (ID %d) Score = %.2f\n", i + 1, entries[i].data->name, entries[i].data->id,
+               entries[i].scoreTenths / 10.0);
+    unlockOwner(owner);
+    free(entries);
+}
+
+void globalLeaderboardMenu() {
+    int k = readIntSafe("How many top Pokemon? ");
+    if (k < 1) {
+        outPrintf("Invalid choice.\n");
+        return;
+    }
+
+    LeaderboardEntry *entries = (LeaderboardEntry *)malloc(sizeof(LeaderboardEntry) * k);
+    if (!entries) {
+        outPrintf("Memory allocation failed for leaderboard.\n");
+        return;
+    }
+    // keep the owners we print alive
+    unsigned long epoch = ringReadBegin();
+    int found = topPokemonGlobal(k, entries);
+    if (found == 0)
+        outPrintf("No owners.\n");
+    for (int i = 0; i < found; i++)
+        outPrintf("%d. %s (ID %d) owned by %s, Score = %.2f\n", i + 1, entries[i].data->name,
+               entries[i].data->id, entries[i].owner->ownerName, entries[i].scoreTenths / 10.0);
+    ringReadEnd(epoch);
+    free(entries);
+}
+
+// --------------------------------------------------------------
+// Frozen Pokedex: Eytzinger layout
+// --------------------------------------------------------------
+
+// in-order walk of the implicit tree, so sorted input lands in Eytzinger order
+void fillEytzinger(FrozenPokedex *frozen, const NodeArray *sorted, int *next, int k) {
+    if (k > frozen->count) return;
+
+    fillEytzinger(frozen, sorted, next, 2 * k);
+    const PokemonData *data = pokemonData(sorted->nodes[(*next)++]);
+    frozen->ids[k] = data->id;
+    frozen->entries[k] = *data; // name still points at the node, which outlives the snapshot
+    fillEytzinger(frozen, sorted, next, 2 * k + 1);
+}
+
+int freezePokedex(OwnerNode *owner) {
+    thawPokedex(owner);
+    int count = pokemonTreeSize(owner->pokedexRoot);
+    if (count == 0) return 0;
+
+    // ids and entries share one block; entries start at an aligned offset
+    size_t idsBytes = sizeof(int) * (count + 1);
+    size_t entriesOffset = (idsBytes + sizeof(PokemonData) - 1) / sizeof(PokemonData) * sizeof(PokemonData);
+    FrozenPokedex *frozen = (FrozenPokedex *)malloc(sizeof(FrozenPokedex));
+    char *block = (char *)malloc(entriesOffset + sizeof(PokemonData) * (count + 1));
+    if (!frozen || !block) {
+        outPrintf("Memory allocation failed for FrozenPokedex.\n");
+        free(frozen);
+        free(block);
+        return 0;
+    }
+    frozen->count = count;
+    frozen->ids = (int *)block;
+    frozen->entries = (PokemonData *)(block + entriesOffset);
+    frozen->ids[0] = 0;
+
+    NodeArray sorted;
+    initNodeArray(&sorted, count);
+    collectInOrder(owner->pokedexRoot, &sorted);
+    int next = 0;
+    fillEytzinger(frozen, &sorted, &next, 1);
+    free(sorted.nodes);
+
+    owner->frozen = frozen;
+    return 1;
+}
+
+void thawPokedex(OwnerNode *owner) {
+    // the stat columns are a read snapshot too
+    freePokemonColumns(owner->columns);
+    owner->columns = NULL;
+
+    if (!owner->frozen) return;
+
+    free(owner->frozen->ids); // start of the shared block
+    free(owner->frozen);
+    owner->frozen = NULL;
+}
+
+const PokemonData *searchFrozenPokedex(const FrozenPokedex *frozen, int id) {
+    const int *ids = frozen->ids;
+    int count = frozen->count;
+    int k = 1;
+    // descend without branching on the comparison; each step pulls in
+    // the cache line holding the descendants a few levels down
+    while (k <= count) {
+        __builtin_prefetch(ids + ((size_t)k << FROZEN_PREFETCH_LEVELS));
+        k = 2 * k + (ids[k] < id);
+    }
+    // undo the trailing right turns to land on the lower bound
+    k >>= __builtin_ffs(~k);
+    if (k == 0 || ids[k] != id) return NULL;
+    return &frozen->entries[k];
+}
+
+const PokemonData *findOwnedPokemon(OwnerNode *owner, int id) {
+    if (owner->frozen)
+        return searchFrozenPokedex(owner->frozen, id);
+
+    // plain BST descent, no queue needed
+    PokemonNode *node = owner->pokedexRoot;
+    while (node && pokemonID(node) != id)
+        node = id < pokemonID(node) ? pokemonLeft(node) : pokemonRight(node);
+    return node ? pokemonData(node) : NULL;
+}
+
+void freezePokedexMenu(OwnerNode *owner) {
+    lockOwnerWrite(owner);
+    if (owner->frozen)
+        outPrintf("Pokedex is already frozen.\n");
+    else if (freezePokedex(owner))
+        outPrintf("Pokedex frozen (%d Pokemon).\n", owner->frozen->count);
+    else
+        outPrintf("Pokedex is empty.\n");
+    unlockOwner(owner);
+}
+
+// --------------------------------------------------------------
+// Struct-of-arrays stat columns and SIMD scan kernels
+// --------------------------------------------------------------
+PokemonColumns *allocPokemonColumns(int count) {
+    PokemonColumns *cols = (PokemonColumns *)malloc(sizeof(PokemonColumns));
+    // three int columns then two byte columns, all in one block
+    char *block = (char *)malloc(sizeof(int) * 3 * (count + 1) + 2 * (count + 1));
+    if (!cols || !block) {
+        outPrintf("Memory allocation failed for PokemonColumns.\n");
+        free(cols);
+        free(block);
+        return NULL;
+    }
+    cols->count = count;
+    cols->ids = (int *)block;
+    cols->hp = cols->ids + count + 1;
+    cols->attack = cols->hp + count + 1;
+    cols->types = (unsigned char *)(cols->attack + count + 1);
+    cols->canEvolve = cols->types + count + 1;
+    return cols;
+}
+
+void setPokemonColumn(PokemonColumns *cols, int i, const PokemonData *data) {
+    cols->ids[i] = data->id;
+    cols->hp[i] = data->hp;
+    cols->attack[i] = data->attack;
+    cols->types[i] = (unsigned char)data->TYPE;
+    cols->canEvolve[i] = (unsigned char)data->CAN_EVOLVE;
+}
+
+void freePokemonColumns(PokemonColumns *cols) {
+    if (!cols) return;
+    free(cols->ids); // start of the shared block
+    free(cols);
+}
+
+void buildSpeciesColumns() {
+    speciesColumns = allocPokemonColumns(speciesCount);
+    if (!speciesColumns) return;
+    for (int i = 0; i < speciesCount; i++)
+        setPokemonColumn(speciesColumns, i, &speciesCatalog[i]);
+}
+
+const PokemonColumns *getSpeciesColumns() {
+    pthread_once(&speciesColumnsOnce, buildSpeciesColumns);
+    return speciesColumns;
+}
+
+const PokemonColumns *getOwnerColumns(OwnerNode *owner) {
+    PokemonColumns *cols = __atomic_load_n(&owner->columns, __ATOMIC_ACQUIRE);
+    if (cols) return cols;
+
+    int count = pokemonTreeSize(owner->pokedexRoot);
+    cols = allocPokemonColumns(count);
+    if (!cols) return NULL;
+
+    PokemonCursor cursor;
+    cursorInit(&cursor, owner->pokedexRoot, ORDER_IN);
+    PokemonNode *node;
+    for (int i = 0; (node = cursorNext(&cursor)) != NULL; i++)
+        setPokemonColumn(cols, i, pokemonData(node));
+    cursorFree(&cursor);
+
+    // several readers may race to build it; the first one to publish wins
+    PokemonColumns *expected = NULL;
+    if (!__atomic_compare_exchange_n(&owner->columns, &expected, cols, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        freePokemonColumns(cols);
+        return expected;
+    }
+    return cols;
+}
+
+// lanes where the mask is set take a, the rest take b
+IntVector blendVector(IntVector mask, IntVector a, IntVector b) {
+    return (a & mask) | (b & ~mask);
+}
+
+void scoreColumns(const PokemonColumns *cols, int *scoreTenths) {
+    const IntVector fifteen = {15, 15, 15, 15};
+    const IntVector twelve = {12, 12, 12, 12};
+    int i = 0;
+    for (; i + SIMD_LANES <= cols->count; i += SIMD_LANES) {
+        IntVector hp, attack;
+        memcpy(&hp, cols->hp + i, sizeof(hp));
+        memcpy(&attack, cols->attack + i, sizeof(attack));
+        IntVector score = attack * fifteen + hp * twelve;
+        memcpy(scoreTenths + i, &score, sizeof(score));
+    }
+    for (; i < cols->count; i++)
+        scoreTenths[i] = cols->attack[i] * 15 + cols->hp[i] * 12;
+}
+
+void scanColumns(const PokemonColumns *cols, const PokemonQuery *query, ColumnStats *stats) {
+    memset(stats, 0, sizeof(ColumnStats));
+    stats->bestIndex = -1;
+
+    const int typeMask = query->typeMask ? (int)query->typeMask : -1;
+    const int evolve = query->evolve;
+    IntVector minID = {query->minID, query->minID, query->minID, query->minID};
+    IntVector maxID = {query->maxID, query->maxID, query->maxID, query->maxID};
+    IntVector minHp = {query->minHp, query->minHp, query->minHp, query->minHp};
+    IntVector minAttack = {query->minAttack, query->minAttack, query->minAttack, query->minAttack};
+    IntVector wantTypes = {typeMask, typeMask, typeMask, typeMask};
+    IntVector wantEvolve = {evolve, evolve, evolve, evolve};
+    IntVector anyEvolve = {evolve < 0 ? -1 : 0, evolve < 0 ? -1 : 0, evolve < 0 ? -1 : 0, evolve < 0 ? -1 : 0};
+    IntVector zero = {0, 0, 0, 0};
+    IntVector one = {1, 1, 1, 1};
+    IntVector countSum = zero, hpSum = zero, attackSum = zero;
+    IntVector bestScore = {-1, -1, -1, -1};
+    IntVector bestIndex = {-1, -1, -1, -1};
+    IntVector lane = {0, 1, 2, 3};
+    IntVector step = {SIMD_LANES, SIMD_LANES, SIMD_LANES, SIMD_LANES};
+
+    int i = 0;
+    for (; i + SIMD_LANES <= cols->count; i += SIMD_LANES, lane += step) {
+        IntVector ids, hp, attack;
+        memcpy(&ids, cols->ids + i, sizeof(ids));
+        memcpy(&hp, cols->hp + i, sizeof(hp));
+        memcpy(&attack, cols->attack + i, sizeof(attack));
+        IntVector types = {cols->types[i], cols->types[i + 1], cols->types[i + 2], cols->types[i + 3]};
+        IntVector evolves = {cols->canEvolve[i], cols->canEvolve[i + 1], cols->canEvolve[i + 2], cols->canEvolve[i + 3]};
+
+        // comparisons give -1 (all bits) for true lanes, 0 for false
+        IntVector match = (ids >= minID) & (ids <= maxID) & (hp >= minHp) & (attack >= minAttack) &
+                          (((one << types) & wantTypes) != zero) & ((evolves == wantEvolve) | anyEvolve);
+
+        countSum -= match;
+        hpSum += hp & match;
+        attackSum += attack & match;
+        IntVector score = blendVector(match, attack * 15 + hp * 12, bestScore);
+        IntVector better = score > bestScore;
+        bestScore = blendVector(better, score, bestScore);
+        bestIndex = blendVector(better, lane, bestIndex);
+
+        for (int l = 0; l < SIMD_LANES; l++)
+            if (match[l]) stats->typeCounts[cols->types[i + l]]++;
+    }
+
+    // fold the lanes (lowest index wins ties, like the scalar tail)
+    int bestTenths = -1;
+    for (int l = 0; l < SIMD_LANES; l++) {
+        stats->count += countSum[l];
+        stats->hpSum += hpSum[l];
+        stats->attackSum += attackSum[l];
+        if (bestScore[l] > bestTenths || (bestScore[l] == bestTenths && bestIndex[l] < stats->bestIndex)) {
+            bestTenths = bestScore[l];
+            stats->bestIndex = bestIndex[l];
+        }
+    }
+
+    for (; i < cols->count; i++) {
+        PokemonData data;
+        data.id = cols->ids[i];
+        data.hp = cols->hp[i];
+        data.attack = cols->attack[i];
+        data.TYPE = (PokemonType)cols->types[i];
+        data.CAN_EVOLVE = (EvolutionStatus)cols->canEvolve[i];
+        if (!pokemonMatchesQuery(&data, query)) continue;
+
+        stats->count++;
+        stats->hpSum += data.hp;
+        stats->attackSum += data.attack;
+        stats->typeCounts[data.TYPE]++;
+        if (pokemonScoreTenths(&data) > bestTenths) {
+            bestTenths = pokemonScoreTenths(&data);
+            stats->bestIndex = i;
+        }
+    }
+    stats->bestScoreTenths = bestTenths;
+}
+
+void printColumnStats(const PokemonColumns *cols, const ColumnStats *stats) {
+    if (stats->count == 0) {
+        outPrintf("No Pokemon matched.\n");
+        return;
+    }
+
+    const PokemonData *best = getSpeciesByID(cols->ids[stats->bestIndex]);
+    outPrintf("Pokemon: %d\n", stats->count);
+    outPrintf("Average HP: %.2f\n", (double)stats->hpSum / stats->count);
+    outPrintf("Average Attack: %.2f\n", (double)stats->attackSum / stats->count);
+    outPrintf("Strongest: %s (ID %d) Score = %.2f\n", best->name, best->id, stats->bestScoreTenths / 10.0);
+    outPrintf("Types:");
+    for (int t = 0; t < POKEMON_TYPE_COUNT; t++)
+        if (stats->typeCounts[t])
+            outPrintf(" %s %d", getTypeName((PokemonType)t), stats->typeCounts[t]);
+    outPrintf("\n");
+}
+
+void ownerStatsMenu(OwnerNode *owner) {
+    PokemonQuery all = {INT_MIN, INT_MAX, 0, INT_MIN, INT_MIN, -1};
+    ColumnStats stats;
+
+    lockOwnerRead(owner);
+    const PokemonColumns *cols = getOwnerColumns(owner);
+    if (cols) {
+        scanColumns(cols, &all, &stats);
+        printColumnStats(cols, &stats);
+    }
+    unlockOwner(owner);
+}
+
+void scanSpeciesMenu() {
+    PokemonQuery query;
+    if (!readPokemonQuery(&query))
+        return;
+
+    const PokemonColumns *cols = getSpeciesColumns();
+    if (!cols) return;
+    ColumnStats stats;
+    scanColumns(cols, &query, &stats);
+    printColumnStats(cols, &stats);
+}
+
+void freeSpeciesColumns() {
+    freePokemonColumns(speciesColumns);
+    speciesColumns = NULL;
+}
+
+// func that clones an owner's Pokedex into a new owner
+void cloneOwnerMenu() {
+    if (!getOwnerHead()) {
+        outPrintf("No existing Pokedexes.\n");
+        return;
+    }
+
+    char sourceName[OWNER_NAME_BUFFER_SIZE];
+    char cloneName[OWNER_NAME_BUFFER_SIZE];
+    outPrintf("Enter name of owner to clone: ");
+    int sourceFits = readOwnerName(sourceName);
+    outPrintf("Enter name for the clone: ");
+    int cloneFits = readOwnerName(cloneName);
+
+    unsigned long epoch = ringReadBegin();
+    OwnerNode *source = sourceFits ? findOwnerByName(sourceName) : NULL;
+    if (!source) {
+        outPrintf("Owner not found.\n");
+    } else if (!cloneFits || strlen(cloneName) == 0) {
+        outPrintf("Invalid name. Please try again.\n");
+    } else if (findOwnerByName(cloneName) != NULL) {
+        outPrintf("Owner '%s' already exists. Not creating a new Pokedex.\n", cloneName);
+    } else {
+        lockOwnerRead(source);
+        PokemonNode *root = sharePokemonTree(source->pokedexRoot);
+        unlockOwner(source);
+
+        OwnerNode *clone = root ? createOwner(cloneName, root) : NULL;
+        if (!clone) {
+            outPrintf("Nothing to clone from %s.\n", sourceName);
+            freePokemonTree(root);
+        } else {
+            linkClonedOwnerInCircularList(clone, source);
+            undoRecordLinked(clone);
+            undoCommit("Clone Pokedex");
+            outPrintf("Cloned %s's Pokedex into %s.\n", sourceName, cloneName);
+        }
+    }
+
+    ringReadEnd(epoch);
+}
+
+void combineOwnerSets(OwnerNode **owners, int count, SetOperation op, NodeArray *result) {
+    PokemonCursor *cursors = (PokemonCursor *)malloc(sizeof(PokemonCursor) * count);
+    PokemonNode **heads = (PokemonNode **)malloc(sizeof(PokemonNode *) * count);
+    if (!cursors || !heads) {
+        outPrintf("Memory allocation failed for set operation.\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        cursorInit(&cursors[i], owners[i]->pokedexRoot, ORDER_IN);
+        heads[i] = cursorNext(&cursors[i]);
+    }
+
+    // every run is sorted by ID, so walk them together one ID at a time
+    for (;;) {
+        int smallest = INT_MAX;
+        for (int i = 0; i < count; i++)
+            if (heads[i] && pokemonID(heads[i]) < smallest) smallest = pokemonID(heads[i]);
+        if (smallest == INT_MAX) break;
+
+        int holders = 0, firstHolds = 0;
+        PokemonNode *match = NULL;
+        for (int i = 0; i < count; i++) {
+            if (!heads[i] || pokemonID(heads[i]) != smallest) continue;
+            if (!match) match = heads[i];
+            if (i == 0) firstHolds = 1;
+            holders++;
+            heads[i] = cursorNext(&cursors[i]);
+        }
+
+        int keep = 0;
+        if (op == SET_INTERSECTION)
+            keep = holders == count;
+        else if (op == SET_DIFFERENCE)
+            keep = firstHolds && holders == 1;
+        else
+            keep = holders % 2 == 1;
+        if (keep)
+            addNode(result, match);
+    }
+
+    for (int i = 0; i < count; i++)
+        cursorFree(&cursors[i]);
+    free(cursors);
+    free(heads);
+}
+
+void setOperationMenu() {
+    // owners are pinned between prompts instead of holding a read section open
+    unsigned long epoch = ringReadBegin();
+    int linked = countLinkedOwners();
+    ringReadEnd(epoch);
+    if (linked < 2) {
+        outPrintf("Not enough owners to compare.\n");
+        return;
+    }
+
+    outPrintf("\n=== Set Operations ===\n");
+    outPrintf("1. Intersection (in every owner)\n");
+    outPrintf("2. Difference (in the first owner only)\n");
+    outPrintf("3. Symmetric Difference (in an odd number of owners)\n");
+    int op = readIntSafe("Your choice: ");
+    if (op < SET_INTERSECTION || op > SET_SYMMETRIC_DIFFERENCE) {
+        outPrintf("Invalid choice.\n");
+        return;
+    }
+
+    int count = readIntSafe("How many owners? ");
+    if (count < 2) {
+        outPrintf("Invalid choice.\n");
+        return;
+    }
+
+    OwnerNode **owners = (OwnerNode **)malloc(sizeof(OwnerNode *) * count);
+    if (!owners) {
+        outPrintf("Memory allocation failed for set operation.\n");
+        exit(1);
+    }
+    char name[OWNER_NAME_BUFFER_SIZE];
+    int total = 0;
+    for (int i = 0; i < count; i++) {
+        outPrintf("Enter name of owner #%d: ", i + 1);
+        OwnerNode *owner = readOwnerName(name) ? findAndPinOwner(name) : NULL;
+        int duplicate = 0;
+        for (int j = 0; owner && j < total; j++)
+            if (owners[j] == owner) duplicate = 1;
+
+        if (!owner) {
+            outPrintf("Owner '%s' not found, skipping.\n", name);
+        } else if (duplicate) {
+            outPrintf("Owner '%s' already listed, skipping.\n", name);
+            unpinOwner(owner);
+        } else {
+            owners[total++] = owner;
+        }
+    }
+    if (total < 2) {
+        outPrintf("Need at least two owners.\n");
+        for (int i = 0; i < total; i++)
+            unpinOwner(owners[i]);
+        free(owners);
+        return;
+    }
+
+    // lock every involved owner in address order
+    OwnerNode **lockOrder = (OwnerNode **)malloc(sizeof(OwnerNode *) * total);
+    if (!lockOrder) {
+        outPrintf("Memory allocation failed for set operation.\n");
+        exit(1);
+    }
+    memcpy(lockOrder, owners, sizeof(OwnerNode *) * total);
+    qsort(lockOrder, total, sizeof(OwnerNode *), compareOwnerAddress);
+    for (int i = 0; i < total; i++)
+        lockOwnerRead(lockOrder[i]);
+
+    NodeArray result;
+    initNodeArray(&result, INITIAL_NODE_ARRAY_CAPACITY);
+    combineOwnerSets(owners, total, (SetOperation)op, &result);
+    for (int i = 0; i < result.size; i++)
+        printPokemonNode(result.nodes[i]);
+    outPrintf("%d Pokemon in the result.\n", result.size);
+
+    // copy the result out before the source trees can change
+    PokemonNode *root = buildBalancedTree(&result, 0, result.size);
+    for (int i = total - 1; i >= 0; i--)
+        unlockOwner(lockOrder[i]);
+
+    if (root) {
+        outPrintf("Save the result as a new owner (empty to skip): ");
+        int fits = readOwnerName(name);
+        if (!fits) {
+            outPrintf("Invalid name. Please try again.\n");
+        } else if (strlen(name) > 0 && findOwnerByName(name) != NULL) {
+            outPrintf("Owner '%s' already exists. Not creating a new Pokedex.\n", name);
+        } else if (strlen(name) > 0) {
+            OwnerNode *owner = createOwner(name, root);
+            if (owner) {
+                linkOwnerInCircularList(owner);
+                undoRecordLinked(owner);
+                undoCommit("Set Operation");
+                outPrintf("New Pokedex created for %s with %d Pokemon.\n", name, result.size);
+                root = NULL;
+            }
+        }
+        freePokemonTree(root);
+    }
+
+    for (int i = 0; i < total; i++)
+        unpinOwner(owners[i]);
+    free(result.nodes);
+    free(lockOrder);
+    free(owners);
+}
+
+PokemonNode *detachPokemonByID(PokemonNode *root, int id, PokemonNode **detached) {
+    if (!root) return NULL;
+
+    root = ownPokemonNode(root);
+    if (id < pokemonID(root)) {
+        setPokemonLeft(root, detachPokemonByID(pokemonLeft(root), id, detached));
+        updatePokemonSummary(root);
+        return root;
+    }
+    if (id > pokemonID(root)) {
+        setPokemonRight(root, detachPokemonByID(pokemonRight(root), id, detached));
+        updatePokemonSummary(root);
+        return root;
+    }
+
+    // root is private here, so its references to the children move to the replacement
+    PokemonNode *replacement;
+    if (!pokemonLeft(root)) {
+        replacement = pokemonRight(root);
+    } else if (!pokemonRight(root)) {
+        replacement = pokemonLeft(root);
+    } else {
+        // unhook the in-order successor and put it where root was
+        PokemonNode *successor = pokemonRight(root);
+        while (pokemonLeft(successor))
+            successor = pokemonLeft(successor);
+        PokemonNode *right = detachPokemonByID(pokemonRight(root), pokemonID(successor), &successor);
+        setPokemonLeft(successor, pokemonLeft(root));
+        setPokemonRight(successor, right);
+        updatePokemonSummary(successor);
+        replacement = successor;
+    }
+
+    root->left = root->right = 0;
+    updatePokemonSummary(root);
+    *detached = root;
+    return replacement;
+}
+
+// func that reads how many and which Pokemon one side of a trade gives
+int *readTradeOffer(OwnerNode *giver, int *count) {
+    outPrintf("How many Pokemon does %s give? ", giver->ownerName);
+    *count = readIntSafe("");
+    // nobody can give more than they hold; also keeps the allocation bounded
+    lockOwnerRead(giver);
+    int held = pokemonTreeSize(giver->pokedexRoot);
+    unlockOwner(giver);
+    if (*count < 0 || *count > held) return NULL;
+
+    int *ids = (int *)malloc(sizeof(int) * (*count + 1));
+    if (!ids) {
+        outPrintf("Memory allocation failed for trade.\n");
+        exit(1);
+    }
+    for (int i = 0; i < *count; i++) {
+        outPrintf("Enter Pokemon ID #%d: ", i + 1);
+        ids[i] = readPokemonIDSafe("");
+    }
+    return ids;
+}
+
+// func that checks one side of a trade; prints why it can't happen
+int validTradeOffer(OwnerNode *giver, OwnerNode *taker, const int *ids, int count,
+                    const int *returned, int returnedCount) {
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < i; j++) {
+            if (ids[j] == ids[i]) {
+                outPrintf("ID %d is listed twice.\n", ids[i]);
+                return 0;
+            }
+        }
+        if (!searchPokemonBFS(giver->pokedexRoot, ids[i])) {
+            outPrintf("%s has no Pokemon with ID %d.\n", giver->ownerName, ids[i]);
+            return 0;
+        }
+
+        // the taker may already have it only if it is giving its own away
+        int givenBack = 0;
+        for (int j = 0; j < returnedCount; j++)
+            if (returned[j] == ids[i]) givenBack = 1;
+        if (!givenBack && searchPokemonBFS(taker->pokedexRoot, ids[i])) {
+            outPrintf("%s already has Pokemon with ID %d.\n", taker->ownerName, ids[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void moveTradedPokemon(OwnerNode *first, const int *firstIds, int firstCount, OwnerNode *second,
+                       const int *secondIds, int secondCount) {
+    thawPokedex(first);
+    thawPokedex(second);
+
+    // detach both offers first so a swapped species never meets itself
+    PokemonNode **moving = (PokemonNode **)malloc(sizeof(PokemonNode *) * (firstCount + secondCount + 1));
+    if (!moving) {
+        outPrintf("Memory allocation failed for trade.\n");
+        exit(1);
+    }
+    for (int i = 0; i < firstCount; i++) {
+        moving[i] = NULL;
+        first->pokedexRoot = detachPokemonByID(first->pokedexRoot, firstIds[i], &moving[i]);
+        indexPokemonRemoved(first, firstIds[i]);
+    }
+    for (int i = 0; i < secondCount; i++) {
+        moving[firstCount + i] = NULL;
+        second->pokedexRoot = detachPokemonByID(second->pokedexRoot, secondIds[i], &moving[firstCount + i]);
+        indexPokemonRemoved(second, secondIds[i]);
+    }
+    for (int i = 0; i < firstCount; i++) {
+        second->pokedexRoot = insertPokemonNode(second->pokedexRoot, moving[i]);
+        indexPokemonAdded(second, firstIds[i]);
+    }
+    for (int i = 0; i < secondCount; i++) {
+        first->pokedexRoot = insertPokemonNode(first->pokedexRoot, moving[firstCount + i]);
+        indexPokemonAdded(first, secondIds[i]);
+    }
+    free(moving);
+}
+
+void tradePokemonMenu() {
+    // both owners are pinned between prompts instead of holding a read section open
+    unsigned long epoch = ringReadBegin();
+    int linked = countLinkedOwners();
+    ringReadEnd(epoch);
+    if (linked < 2) {
+        outPrintf("Not enough owners to trade.\n");
+        return;
+    }
+
+    char firstName[OWNER_NAME_BUFFER_SIZE];
+    char secondName[OWNER_NAME_BUFFER_SIZE];
+    outPrintf("Enter name of first owner: ");
+    OwnerNode *first = readOwnerName(firstName) ? findAndPinOwner(firstName) : NULL;
+    outPrintf("Enter name of second owner: ");
+    OwnerNode *second = readOwnerName(secondName) ? findAndPinOwner(secondName) : NULL;
+    if (!first || !second) {
+        outPrintf("One or both owners not found.\n");
+        unpinOwner(first);
+        unpinOwner(second);
+        return;
+    }
+    if (first == second) {
+        outPrintf("Cannot trade with yourself.\n");
+        unpinOwner(first);
+        unpinOwner(second);
+        return;
+    }
+
+    int firstCount, secondCount;
+    int *firstIds = readTradeOffer(first, &firstCount);
+    int *secondIds = firstIds ? readTradeOffer(second, &secondCount) : NULL;
+    if (!firstIds || !secondIds || firstCount + secondCount == 0) {
+        outPrintf("Invalid choice.\n");
+        free(firstIds);
+        free(secondIds);
+        unpinOwner(first);
+        unpinOwner(second);
+        return;
+    }
+
+    // lock both owners in address order
+    OwnerNode *lockOrder[2] = {first, second};
+    qsort(lockOrder, 2, sizeof(OwnerNode *), compareOwnerAddress);
+    lockOwnerWrite(lockOrder[0]);
+    lockOwnerWrite(lockOrder[1]);
+
+    // check everything before anything moves
+    if (!validTradeOffer(first, second, firstIds, firstCount, secondIds, secondCount) ||
+        !validTradeOffer(second, first, secondIds, secondCount, firstIds, firstCount)) {
+        outPrintf("Trade cancelled. No changes made.\n");
+    } else {
+        moveTradedPokemon(first, firstIds, firstCount, second, secondIds, secondCount);
+        undoRecordTrade(first, firstIds, firstCount, second, secondIds, secondCount);
+        outPrintf("Trade completed: %s gave %d Pokemon, %s gave %d.\n",
+               first->ownerName, firstCount, second->ownerName, secondCount);
+    }
+
+    unlockOwner(lockOrder[1]);
+    unlockOwner(lockOrder[0]);
+    undoCommit("Trade Pokemon");
+    unpinOwner(first);
+    unpinOwner(second);
+    free(firstIds);
+    free(secondIds);
+}
+
+// func that appends to a growable undo array
+void *undoAppend(void *items, int count, size_t itemSize) {
+    // grow at powers of two
+    if (count == 0 || (count & (count - 1)) == 0) {
+        items = realloc(items, itemSize * (count ? count * 2 : 1));
+        if (!items) {
+            outPrintf("Memory allocation failed for undo log.\n");
+            exit(1);
+        }
+    }
+    return items;
+}
+
+void undoRecordRoot(OwnerNode *owner, PokemonNode *before) {
+    if (before == owner->pokedexRoot) {
+        freePokemonTree(before); // nothing changed
+        return;
+    }
+    undoPending.roots = (UndoRootChange *)undoAppend(undoPending.roots, undoPending.rootCount,
+                                                      sizeof(UndoRootChange));
+    UndoRootChange *change = &undoPending.roots[undoPending.rootCount++];
+    change->owner = owner;
+    change->before = before;
+    change->after = sharePokemonTree(owner->pokedexRoot);
+
+    // claim the owner's staged index changes, keeping their order
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    int count = 0;
+    for (int i = 0; i < undoStagedIndexCount; i++)
+        if (undoStagedIndex[i].owner == owner) count++;
+    change->indexChanges = (int *)malloc(sizeof(int) * (count + 1));
+    if (!change->indexChanges) {
+        outPrintf("Memory allocation failed for undo log.\n");
+        exit(1);
+    }
+    change->indexChangeCount = 0;
+    int kept = 0;
+    for (int i = 0; i < undoStagedIndexCount; i++) {
+        if (undoStagedIndex[i].owner == owner)
+            change->indexChanges[change->indexChangeCount++] = undoStagedIndex[i].change;
+        else
+            undoStagedIndex[kept++] = undoStagedIndex[i];
+    }
+    undoStagedIndexCount = kept;
+    pthread_rwlock_unlock(&speciesIndexLock);
+}
+
+void undoStageIndexChange(OwnerNode *owner, int change) {
+    undoStagedIndex = (UndoIndexChange *)undoAppend(undoStagedIndex, undoStagedIndexCount,
+                                                    sizeof(UndoIndexChange));
+    undoStagedIndex[undoStagedIndexCount].owner = owner;
+    undoStagedIndex[undoStagedIndexCount].change = change;
+    undoStagedIndexCount++;
+}
+
+// func that forgets staged index changes no root change claimed (trades replay
+// their own, ring links reindex the whole owner)
+void undoDropStagedIndex() {
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    free(undoStagedIndex);
+    undoStagedIndex = NULL;
+    undoStagedIndexCount = 0;
+    pthread_rwlock_unlock(&speciesIndexLock);
+}
+
+void undoRecordTrade(OwnerNode *first, const int *firstIds, int firstCount, OwnerNode *second,
+                     const int *secondIds, int secondCount) {
+    undoPending.trades = (UndoTradeChange *)undoAppend(undoPending.trades, undoPending.tradeCount,
+                                                        sizeof(UndoTradeChange));
+    UndoTradeChange *change = &undoPending.trades[undoPending.tradeCount++];
+    change->first = first;
+    change->second = second;
+    change->firstCount = firstCount;
+    change->secondCount = secondCount;
+    change->ids = (int *)malloc(sizeof(int) * (firstCount + secondCount + 1));
+    if (!change->ids) {
+        outPrintf("Memory allocation failed for undo log.\n");
+        exit(1);
+    }
+    memcpy(change->ids, firstIds, sizeof(int) * firstCount);
+    memcpy(change->ids + firstCount, secondIds, sizeof(int) * secondCount);
+}
+
+void undoRecordLinked(OwnerNode *owner) {
+    undoPending.linked = (UndoOwnerChange *)undoAppend(undoPending.linked, undoPending.linkedCount,
+                                                        sizeof(UndoOwnerChange));
+    UndoOwnerChange *change = &undoPending.linked[undoPending.linkedCount++];
+    change->owner = owner;
+    change->prev = NULL;
+    change->wasHead = 0;
+}
+
+void undoRecordUnlinked(OwnerNode *owner, OwnerNode *prev, int wasHead) {
+    undoPending.unlinked = (UndoOwnerChange *)undoAppend(undoPending.unlinked, undoPending.unlinkedCount,
+                                                          sizeof(UndoOwnerChange));
+    UndoOwnerChange *change = &undoPending.unlinked[undoPending.unlinkedCount++];
+    change->owner = owner;
+    change->prev = prev == owner ? NULL : prev;
+    change->wasHead = wasHead;
+}
+
+// func that forgets a change; owners unlinked in its current state are retired
+void releaseUndoRecord(UndoRecord *record, int isDone) {
+    for (int i = 0; i < record->rootCount; i++) {
+        freePokemonTree(record->roots[i].before);
+        freePokemonTree(record->roots[i].after);
+        free(record->roots[i].indexChanges);
+    }
+
+    UndoOwnerChange *detached = isDone ? record->unlinked : record->linked;
+    int detachedCount = isDone ? record->unlinkedCount : record->linkedCount;
+    if (detachedCount > 0) {
+        pthread_mutex_lock(&ownerRingLock);
+        for (int i = 0; i < detachedCount; i++)
+            retireOwner(detached[i].owner);
+        reclaimRetiredOwners();
+        pthread_mutex_unlock(&ownerRingLock);
+    }
+
+    for (int i = 0; i < record->tradeCount; i++)
+        free(record->trades[i].ids);
+
+    free(record->roots);
+    free(record->trades);
+    free(record->linked);
+    free(record->unlinked);
+    memset(record, 0, sizeof(UndoRecord));
+}
+
+void undoCommit(const char *label) {
+    undoDropStagedIndex();
+    if (!undoPending.rootCount && !undoPending.tradeCount && !undoPending.linkedCount &&
+        !undoPending.unlinkedCount)
+        return;
+
+    pthread_mutex_lock(&undoLock);
+    // a new change ends the redo branch
+    for (int i = undoTop; i < undoEnd; i++)
+        releaseUndoRecord(&undoLog[(undoBase + i) % UNDO_LOG_CAPACITY], 0);
+    undoEnd = undoTop;
+
+    if (undoTop == UNDO_LOG_CAPACITY) {
+        releaseUndoRecord(&undoLog[undoBase], 1);
+        undoBase = (undoBase + 1) % UNDO_LOG_CAPACITY;
+        undoTop--;
+    }
+
+    undoPending.label = label;
+    undoLog[(undoBase + undoTop) % UNDO_LOG_CAPACITY] = undoPending;
+    undoEnd = ++undoTop;
+    memset(&undoPending, 0, sizeof(UndoRecord));
+    pthread_mutex_unlock(&undoLock);
+}
+
+// func that moves an owner to one side of a logged root change and replays the
+// index changes that got it there, backwards when undoing
+void applyRootChange(const UndoRootChange *change, int reverse) {
+    OwnerNode *owner = change->owner;
+    lockOwnerWrite(owner);
+    thawPokedex(owner);
+    pthread_rwlock_wrlock(&speciesIndexLock);
+    for (int k = 0; k < change->indexChangeCount; k++) {
+        int c = change->indexChanges[reverse ? change->indexChangeCount - 1 - k : k];
+        // undoing an add removes, undoing a removal adds
+        aggregateSpeciesChange(owner, c > 0 ? c : -c, (c > 0) != reverse);
+    }
+    pthread_rwlock_unlock(&speciesIndexLock);
+    PokemonNode *old = owner->pokedexRoot;
+    owner->pokedexRoot = sharePokemonTree(reverse ? change->before : change->after);
+    freePokemonTree(old);
+    unlockOwner(owner);
+}
+
+// func that replays a logged trade forwards, or backwards by swapping the offers
+void applyTradeChange(const UndoTradeChange *change, int reverse) {
+    const int *firstIds = change->ids;
+    const int *secondIds = change->ids + change->firstCount;
+    OwnerNode *lockOrder[2] = {change->first, change->second};
+    qsort(lockOrder, 2, sizeof(OwnerNode *), compareOwnerAddress);
+    lockOwnerWrite(lockOrder[0]);
+    lockOwnerWrite(lockOrder[1]);
+    if (reverse)
+        moveTradedPokemon(change->first, secondIds, change->secondCount, change->second, firstIds,
+                          change->firstCount);
+    else
+        moveTradedPokemon(change->first, firstIds, change->firstCount, change->second, secondIds,
+                          change->secondCount);
+    unlockOwner(lockOrder[1]);
+    unlockOwner(lockOrder[0]);
+}
+
+void undoLastChange() {
+    pthread_mutex_lock(&undoLock);
+    if (undoTop == 0) {
+        outPrintf("Nothing to undo.\n");
+        pthread_mutex_unlock(&undoLock);
+        return;
+    }
+    UndoRecord *record = &undoLog[(undoBase + undoTop - 1) % UNDO_LOG_CAPACITY];
+
+    // walk the change backwards: removed owners, roots, added owners
+    pthread_mutex_lock(&ownerRingLock);
+    for (int i = record->unlinkedCount - 1; i >= 0; i--) {
+        UndoOwnerChange *change = &record->unlinked[i];
+        relinkOwnerLocked(change->owner, change->prev, change->wasHead);
+    }
+    pthread_mutex_unlock(&ownerRingLock);
+
+    for (int i = record->tradeCount - 1; i >= 0; i--)
+        applyTradeChange(&record->trades[i], 1);
+    for (int i = record->rootCount - 1; i >= 0; i--)
+        applyRootChange(&record->roots[i], 1);
+
+    pthread_mutex_lock(&ownerRingLock);
+    for (int i = record->linkedCount - 1; i >= 0; i--) {
+        UndoOwnerChange *change = &record->linked[i];
+        change->prev = change->owner->prev == change->owner ? NULL : change->owner->prev;
+        change->wasHead = change->owner == ownerHead;
+        unlinkOwnerLocked(change->owner);
+    }
+    pthread_mutex_unlock(&ownerRingLock);
+
+    undoDropStagedIndex(); // replayed trades staged theirs again
+    undoTop--;
+    outPrintf("Undone: %s.\n", record->label);
+    pthread_mutex_unlock(&undoLock);
+}
+
+void redoLastChange() {
+    pthread_mutex_lock(&undoLock);
+    if (undoTop == undoEnd) {
+        outPrintf("Nothing to redo.\n");
+        pthread_mutex_unlock(&undoLock);
+        return;
+    }
+    UndoRecord *record = &undoLog[(undoBase + undoTop) % UNDO_LOG_CAPACITY];
+
+    pthread_mutex_lock(&ownerRingLock);
+    for (int i = 0; i < record->linkedCount; i++) {
+        UndoOwnerChange *change = &record->linked[i];
+        relinkOwnerLocked(change->owner, change->prev, change->wasHead);
+    }
+    pthread_mutex_unlock(&ownerRingLock);
+
+    for (int i = 0; i < record->rootCount; i++)
+        applyRootChange(&record->roots[i], 0);
+    for (int i = 0; i < record->tradeCount; i++)
+        applyTradeChange(&record->trades[i], 0);
+
+    pthread_mutex_lock(&ownerRingLock);
+    for (int i = 0; i < record->unlinkedCount; i++) {
+        UndoOwnerChange *change = &record->unlinked[i];
+        change->prev = change->owner->prev == change->owner ? NULL : change->owner->prev;
+        change->wasHead = change->owner == ownerHead;
+        unlinkOwnerLocked(change->owner);
+    }
+    pthread_mutex_unlock(&ownerRingLock);
+
+    undoDropStagedIndex();
+    undoTop++;
+    outPrintf("Redone: %s.\n", record->label);
+    pthread_mutex_unlock(&undoLock);
+}
+
+void freeUndoLog() {
+    pthread_mutex_lock(&undoLock);
+    for (int i = 0; i < undoEnd; i++)
+        releaseUndoRecord(&undoLog[(undoBase + i) % UNDO_LOG_CAPACITY], i < undoTop);
+    undoBase = undoTop = undoEnd = 0;
+    undoDropStagedIndex();
+    pthread_mutex_unlock(&undoLock);
+}
+
+const PokemonData *getSpeciesByID(int id) {
+    if (id < 1 || id > speciesCount) return NULL;
+    return &speciesCatalog[id - 1];
+}
+
+// func that checks one loaded entry; nodes assume entry i holds ID i + 1
+int validCatalogEntry(const PokemonData *entry, int index, int count) {
+    if (entry->id != index + 1) return 0;
+    if ((int)entry->TYPE < 0 || (int)entry->TYPE >= POKEMON_TYPE_COUNT) return 0;
+    // node summaries keep stats in 16 bits
+    if (entry->hp < 0 || entry->hp > USHRT_MAX || entry->attack < 0 || entry->attack > USHRT_MAX)
+        return 0;
+    if (entry->CAN_EVOLVE != CAN_EVOLVE && entry->CAN_EVOLVE != CANNOT_EVOLVE) return 0;
+    // evolving means ID + 1, which has to exist
+    if (entry->CAN_EVOLVE == CAN_EVOLVE && index + 1 >= count) return 0;
+    return entry->name && entry->name[0] != '\0';
+}
+
+// func that maps a binary catalog; records are checked and copied into PokemonData
+// entries (one pass over the file), names stay inside the mapping
+int loadBinaryCatalog(int fd, size_t size) {
+    if (size < sizeof(CatalogFileHeader)) return 0;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return 0;
+
+    const CatalogFileHeader *header = (const CatalogFileHeader *)map;
+    size_t recordBytes = size - sizeof(CatalogFileHeader);
+    int count = header->count;
+    int nameBytes = header->nameBytes;
+    if (count < 1 || nameBytes < 1 || (size_t)count > recordBytes / sizeof(CatalogFileRecord) ||
+        recordBytes - (size_t)count * sizeof(CatalogFileRecord) != (size_t)nameBytes) {
+        munmap(map, size);
+        return 0;
+    }
+    const CatalogFileRecord *records = (const CatalogFileRecord *)(header + 1);
+    const char *names = (const char *)(records + count);
+    if (names[nameBytes - 1] != '\0') {
+        munmap(map, size);
+        return 0;
+    }
+
+    PokemonData *entries = (PokemonData *)malloc(sizeof(PokemonData) * count);
+    if (!entries) {
+        munmap(map, size);
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        const CatalogFileRecord *record = &records[i];
+        entries[i].id = record->id;
+        entries[i].name = (record->nameOffset >= 0 && record->nameOffset < nameBytes)
+                              ? (char *)(names + record->nameOffset)
+                              : NULL;
+        entries[i].TYPE = (PokemonType)record->type;
+        entries[i].hp = record->hp;
+        entries[i].attack = record->attack;
+        entries[i].CAN_EVOLVE = (EvolutionStatus)record->canEvolve;
+        if (!validCatalogEntry(&entries[i], i, count)) {
+            outPrintf("Catalog entry %d is invalid.\n", i + 1);
+            free(entries);
+            munmap(map, size);
+            return 0;
+        }
+    }
+
+    catalogMapping = map;
+    catalogMappingSize = size;
+    catalogEntries = entries;
+    speciesCount = count;
+    return 1;
+}
+
+// func that reads a CSV type column: a type name or its number
+int parseCatalogType(char *text) {
+    for (char *p = text; *p; p++)
+        *p = (char)toupper((unsigned char)*p);
+    for (int type = 0; type < POKEMON_TYPE_COUNT; type++)
+        if (strcmp(text, getTypeName((PokemonType)type)) == 0) return type;
+
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < 0 || value >= POKEMON_TYPE_COUNT) return -1;
+    return (int)value;
+}
+
+// func that reads an integer CSV column
+int parseCatalogInt(const char *text, int *out) {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < INT_MIN || value > INT_MAX) return 0;
+    *out = (int)value;
+    return 1;
+}
+
+#define CATALOG_CSV_COLUMNS 6
+
+// func that parses a CSV catalog; names point into the file buffer, which is kept
+int loadCsvCatalog(FILE *file) {
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0) return 0;
+
+    char *buffer = (char *)malloc((size_t)size + 1);
+    if (!buffer) return 0;
+    if (fread(buffer, 1, (size_t)size, file) != (size_t)size) {
+        free(buffer);
+        return 0;
+    }
+    buffer[size] = '\0';
+
+    int count = 0, capacity = 256;
+    PokemonData *entries = (PokemonData *)malloc(sizeof(PokemonData) * capacity);
+    int ok = entries != NULL;
+    int lineNumber = 0;
+    char *line = buffer;
+    while (ok && line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        lineNumber++;
+        trimWhitespace(line);
+        if (line[0] == '\0' || line[0] == '#') {
+            line = next;
+            continue;
+        }
+
+        char *fields[CATALOG_CSV_COLUMNS];
+        int fieldCount = 0;
+        char *field = line;
+        while (field && fieldCount < CATALOG_CSV_COLUMNS) {
+            char *comma = strchr(field, ',');
+            if (comma) *comma++ = '\0';
+            trimWhitespace(field);
+            fields[fieldCount++] = field;
+            field = comma;
+        }
+
+        // optional header row
+        if (count == 0 && !isdigit((unsigned char)fields[0][0])) {
+            line = next;
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            PokemonData *grown = (PokemonData *)realloc(entries, sizeof(PokemonData) * capacity);
+            if (!grown) {
+                ok = 0;
+                break;
+            }
+            entries = grown;
+        }
+
+        PokemonData *entry = &entries[count];
+        int type = -1, canEvolve = -1;
+        if (fieldCount != CATALOG_CSV_COLUMNS || field ||
+            !parseCatalogInt(fields[0], &entry->id) ||
+            (type = parseCatalogType(fields[2])) < 0 ||
+            !parseCatalogInt(fields[3], &entry->hp) ||
+            !parseCatalogInt(fields[4], &entry->attack) ||
+            !parseCatalogInt(fields[5], &canEvolve)) {
+            outPrintf("Catalog line %d is invalid.\n", lineNumber);
+            ok = 0;
+            break;
+        }
+        entry->name = fields[1];
+        entry->TYPE = (PokemonType)type;
+        entry->CAN_EVOLVE = (EvolutionStatus)canEvolve;
+        count++;
+        line = next;
+    }
+
+    // evolution checks need the final count
+    for (int i = 0; ok && i < count; i++) {
+        if (!validCatalogEntry(&entries[i], i, count)) {
+            outPrintf("Catalog entry %d is invalid.\n", i + 1);
+            ok = 0;
+        }
+    }
+    if (!ok || count == 0) {
+        free(entries);
+        free(buffer);
+        return 0;
+    }
+
+    catalogNames = buffer;
+    catalogEntries = entries;
+    speciesCount = count;
+    return 1;
+}
+
+int loadSpeciesCatalog(const char *path) {
+    // owners point into the catalog, so it can only be swapped before any exist
+    if (!path || ownerHead || catalogEntries) return 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        outPrintf("Cannot open catalog %s.\n", path);
+        return 0;
+    }
+    struct stat st;
+    char magic[CATALOG_MAGIC_LENGTH];
+    int loaded = 0;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(magic) &&
+        read(fd, magic, sizeof(magic)) == (ssize_t)sizeof(magic) &&
+        memcmp(magic, CATALOG_MAGIC, sizeof(magic)) == 0) {
+        loaded = loadBinaryCatalog(fd, (size_t)st.st_size);
+        close(fd);
+    } else {
+        close(fd);
+        FILE *file = fopen(path, "r");
+        if (file) {
+            loaded = loadCsvCatalog(file);
+            fclose(file);
+        }
+    }
+
+    // the starter menu offers IDs 1, 4 and 7; nodes keep IDs in 16 bits
+    if (loaded && (speciesCount <= SQUIRTLE_INDEX || speciesCount > POKEMON_NODE_MAX_SPECIES)) {
+        freeSpeciesCatalog();
+        loaded = 0;
+    }
+    if (!loaded) {
+        outPrintf("Catalog %s is invalid. Using the built-in Pokedex.\n", path);
+        return 0;
+    }
+    speciesCatalog = catalogEntries;
+    return 1;
+}
+
+int writeSpeciesCatalog(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return 0;
+
+    CatalogFileHeader header;
+    memcpy(header.magic, CATALOG_MAGIC, CATALOG_MAGIC_LENGTH);
+    header.count = speciesCount;
+    header.nameBytes = 0;
+    for (int i = 0; i < speciesCount; i++)
+        header.nameBytes += (int)strlen(speciesCatalog[i].name) + 1;
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    int nameOffset = 0;
+    for (int i = 0; ok && i < speciesCount; i++) {
+        const PokemonData *species = &speciesCatalog[i];
+        CatalogFileRecord record = {species->id, (int)species->TYPE, species->hp,
+                                    species->attack, (int)species->CAN_EVOLVE, nameOffset};
+        ok = fwrite(&record, sizeof(record), 1, file) == 1;
+        nameOffset += (int)strlen(species->name) + 1;
+    }
+    for (int i = 0; ok && i < speciesCount; i++)
+        ok = fwrite(speciesCatalog[i].name, strlen(speciesCatalog[i].name) + 1, 1, file) == 1;
+
+    if (fclose(file) != 0) ok = 0;
+    return ok;
+}
+
+void freeSpeciesCatalog() {
+    speciesCatalog = pokedex;
+    speciesCount = BUILTIN_POKEDEX_SIZE;
+    free(catalogEntries);
+    free(catalogNames);
+    if (catalogMapping) munmap(catalogMapping, catalogMappingSize);
+    catalogEntries = NULL;
+    catalogNames = NULL;
+    catalogMapping = NULL;
+    catalogMappingSize = 0;
+}
+
+unsigned long long hashSpeciesName(const char *name) {
+    // FNV-1a over the lowercased bytes
+    unsigned long long hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= (unsigned char)tolower(*p);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// func that picks a name's slot for a given bucket seed
+int speciesNameSlot(unsigned long long hash, int seed) {
+    unsigned long long x = hash + (unsigned long long)seed * 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return (int)(x % (unsigned long long)speciesCount);
+}
+
+int sameSpeciesName(const char *a, const char *b) {
+    while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+        a++;
+        b++;
+    }
+    return tolower((unsigned char)*a) == tolower((unsigned char)*b);
+}
+
+typedef struct
+{
+    int bucket;
+    int size;
+} NameBucket;
+
+int compareNameBucketsBySize(const void *a, const void *b) {
+    const NameBucket *bucketA = (const NameBucket *)a;
+    const NameBucket *bucketB = (const NameBucket *)b;
+    return bucketA->size != bucketB->size ? bucketB->size - bucketA->size : bucketA->bucket - bucketB->bucket;
+}
+
+void buildSpeciesNameHash() {
+    int count = speciesCount;
+    int bucketCount = count / SPECIES_NAME_BUCKET_LOAD + 1;
+    unsigned long long *hashes = (unsigned long long *)malloc(sizeof(unsigned long long) * count);
+    int *bucketStart = (int *)calloc(bucketCount + 1, sizeof(int));
+    int *members = (int *)malloc(sizeof(int) * count);
+    int *trial = (int *)malloc(sizeof(int) * count);
+    NameBucket *order = (NameBucket *)malloc(sizeof(NameBucket) * bucketCount);
+    speciesNameSeeds = (int *)calloc(bucketCount, sizeof(int));
+    speciesNameSlots = (int *)calloc(count, sizeof(int));
+    speciesNameHashes = (unsigned long long *)calloc(count, sizeof(unsigned long long));
+    if (!hashes || !bucketStart || !members || !trial || !order || !speciesNameSeeds ||
+        !speciesNameSlots || !speciesNameHashes) {
+        outPrintf("Memory allocation failed for name lookup.\n");
+        exit(1);
+    }
+    speciesNameBucketCount = bucketCount;
+
+    // group species by bucket (counting sort)
+    for (int i = 0; i < count; i++) {
+        hashes[i] = hashSpeciesName(speciesCatalog[i].name);
+        bucketStart[(hashes[i] >> 32) % bucketCount + 1]++;
+    }
+    for (int b = 0; b < bucketCount; b++)
+        bucketStart[b + 1] += bucketStart[b];
+    for (int b = 0; b < bucketCount; b++)
+        order[b].size = 0;
+    for (int i = 0; i < count; i++) {
+        int b = (int)((hashes[i] >> 32) % bucketCount);
+        members[bucketStart[b] + order[b].size++] = i;
+    }
+    for (int b = 0; b < bucketCount; b++)
+        order[b].bucket = b;
+
+    // place the biggest buckets first, while most slots are free
+    qsort(order, bucketCount, sizeof(NameBucket), compareNameBucketsBySize);
+    int ok = 1;
+    for (int o = 0; ok && o < bucketCount && order[o].size > 0; o++) {
+        int b = order[o].bucket;
+        int *keys = &members[bucketStart[b]];
+        int size = order[o].size;
+
+        // a repeated name (in any case) can never get two slots; keep the first
+        for (int i = 1; i < size; i++) {
+            for (int j = 0; j < i; j++) {
+                if (hashes[keys[i]] == hashes[keys[j]] &&
+                    sameSpeciesName(speciesCatalog[keys[i]].name, speciesCatalog[keys[j]].name)) {
+                    keys[i--] = keys[--size];
+                    break;
+                }
+            }
+        }
+
+        int seed = 0;
+        for (; seed < SPECIES_NAME_MAX_SEED; seed++) {
+            int placed = 0;
+            for (; placed < size; placed++) {
+                int slot = speciesNameSlot(hashes[keys[placed]], seed);
+                int taken = speciesNameSlots[slot] != 0;
+                for (int j = 0; !taken && j < placed; j++)
+                    taken = trial[j] == slot;
+                if (taken) break;
+                trial[placed] = slot;
+            }
+            if (placed == size) break;
+        }
+        if (seed == SPECIES_NAME_MAX_SEED) {
+            ok = 0;
+            break;
+        }
+
+        speciesNameSeeds[b] = seed;
+        for (int i = 0; i < size; i++) {
+            speciesNameSlots[trial[i]] = speciesCatalog[keys[i]].id;
+            speciesNameHashes[trial[i]] = hashes[keys[i]];
+        }
+    }
+
+    free(hashes);
+    free(bucketStart);
+    free(members);
+    free(trial);
+    free(order);
+    if (!ok) {
+        outPrintf("Name lookup unavailable for this catalog.\n");
+        freeSpeciesNameHash();
+    }
+}
+
+int findSpeciesIDByName(const char *name) {
+    if (!name || !name[0]) return 0;
+    pthread_once(&speciesNameOnce, buildSpeciesNameHash);
+    if (!speciesNameSlots) return 0;
+
+    unsigned long long hash = hashSpeciesName(name);
+    int seed = speciesNameSeeds[(hash >> 32) % speciesNameBucketCount];
+    int slot = speciesNameSlot(hash, seed);
+    int id = speciesNameSlots[slot];
+    // names outside the catalog land on some slot too; one check rejects them
+    if (!id || speciesNameHashes[slot] != hash || !sameSpeciesName(getSpeciesByID(id)->name, name))
+        return 0;
+    return id;
+}
+
+void freeSpeciesNameHash() {
+    free(speciesNameSeeds);
+    free(speciesNameSlots);
+    free(speciesNameHashes);
+    speciesNameSeeds = NULL;
+    speciesNameSlots = NULL;
+    speciesNameHashes = NULL;
+    speciesNameBucketCount = 0;
+}
+
+NameTrieNode *newNameTrieNode(const char *label, int labelLength) {
+    NameTrieNode *node = (NameTrieNode *)calloc(1, sizeof(NameTrieNode));
+    if (node) node->label = (char *)malloc(labelLength + 1);
+    if (!node || !node->label) {
+        outPrintf("Memory allocation failed for name trie.\n");
+        exit(1);
+    }
+    memcpy(node->label, label, labelLength);
+    node->label[labelLength] = '\0';
+    node->labelLength = labelLength;
+    return node;
+}
+
+void freeNameTrieNode(NameTrieNode *node) {
+    while (node->values) {
+        NameTrieValue *next = node->values->next;
+        free(node->values);
+        node->values = next;
+    }
+    free(node->label);
+    free(node);
+}
+
+// func that lowercases a name into a new string
+char *foldName(const char *name) {
+    char *folded = myStrdup(name);
+    if (!folded) {
+        outPrintf("Memory allocation failed for name trie.\n");
+        exit(1);
+    }
+    for (char *p = folded; *p; p++)
+        *p = (char)tolower((unsigned char)*p);
+    return folded;
+}
+
+void nameTrieInsert(NameTrieNode *root, const char *name, const void *item) {
+    char *key = foldName(name);
+    NameTrieNode *node = root;
+    const char *rest = key;
+
+    while (*rest) {
+        // children are kept sorted by first character
+        NameTrieNode **link = &node->child;
+        while (*link && (unsigned char)(*link)->label[0] < (unsigned char)*rest)
+            link = &(*link)->sibling;
+
+        NameTrieNode *child = *link;
+        if (!child || child->label[0] != *rest) {
+            NameTrieNode *leaf = newNameTrieNode(rest, (int)strlen(rest));
+            leaf->sibling = child;
+            *link = leaf;
+            node = leaf;
+            break;
+        }
+
+        int common = 0;
+        while (common < child->labelLength && child->label[common] == rest[common])
+            common++;
+        if (common < child->labelLength) {
+            // split the edge: new node for the shared part, child keeps the tail
+            NameTrieNode *mid = newNameTrieNode(child->label, common);
+            memmove(child->label, child->label + common, child->labelLength - common + 1);
+            child->labelLength -= common;
+            mid->sibling = child->sibling;
+            child->sibling = NULL;
+            mid->child = child;
+            *link = mid;
+            child = mid;
+        }
+        node = child;
+        rest += common;
+    }
+
+    NameTrieValue *value = (NameTrieValue *)malloc(sizeof(NameTrieValue));
+    if (!value) {
+        outPrintf("Memory allocation failed for name trie.\n");
+        exit(1);
+    }
+    value->name = name;
+    value->item = item;
+    value->next = node->values;
+    node->values = value;
+    free(key);
+}
+
+// func that removes key below node; returns what replaces node in its parent
+NameTrieNode *removeFromNameTrie(NameTrieNode *node, const char *key, const void *item, int isRoot) {
+    if (*key == '\0') {
+        NameTrieValue **link = &node->values;
+        while (*link && (*link)->item != item)
+            link = &(*link)->next;
+        if (*link) {
+            NameTrieValue *gone = *link;
+            *link = gone->next;
+            free(gone);
+        }
+    } else {
+        NameTrieNode **link = &node->child;
+        while (*link && (*link)->label[0] != *key)
+            link = &(*link)->sibling;
+        NameTrieNode *child = *link;
+        if (!child || strncmp(child->label, key, child->labelLength) != 0) return node;
+        *link = removeFromNameTrie(child, key + child->labelLength, item, 0);
+    }
+
+    if (isRoot || node->values) return node;
+    if (!node->child) {
+        // nothing left below: drop the node
+        NameTrieNode *sibling = node->sibling;
+        freeNameTrieNode(node);
+        return sibling;
+    }
+    if (!node->child->sibling) {
+        // one child left: fold this edge into it
+        NameTrieNode *child = node->child;
+        char *label = (char *)malloc(node->labelLength + child->labelLength + 1);
+        if (!label) {
+            outPrintf("Memory allocation failed for name trie.\n");
+            exit(1);
+        }
+        memcpy(label, node->label, node->labelLength);
+        memcpy(label + node->labelLength, child->label, child->labelLength + 1);
+        free(child->label);
+        child->label = label;
+        child->labelLength += node->labelLength;
+        child->sibling = node->sibling;
+        freeNameTrieNode(node);
+        return child;
+    }
+    return node;
+}
+
+void nameTrieRemove(NameTrieNode *root, const char *name, const void *item) {
+    char *key = foldName(name);
+    removeFromNameTrie(root, key, item, 1);
+    free(key);
+}
+
+// func that lists the names of a subtree in alphabetical order
+void collectNameTrie(const NameTrieNode *node, int max, NameMatch *out, int *found) {
+    for (const NameTrieValue *value = node->values; value && *found < max; value = value->next) {
+        out[*found].name = value->name;
+        out[*found].item = value->item;
+        out[*found].distance = 0;
+        (*found)++;
+    }
+    for (const NameTrieNode *child = node->child; child && *found < max; child = child->sibling)
+        collectNameTrie(child, max, out, found);
+}
+
+int nameTrieComplete(const NameTrieNode *root, const char *prefix, int max, NameMatch *out) {
+    const NameTrieNode *node = root;
+    const unsigned char *rest = (const unsigned char *)prefix;
+
+    while (*rest) {
+        const NameTrieNode *child = node->child;
+        while (child && child->label[0] != (char)tolower(*rest))
+            child = child->sibling;
+        if (!child) return 0;
+
+        // the prefix may end inside the edge label
+        int i = 0;
+        while (i < child->labelLength && rest[i] && child->label[i] == (char)tolower(rest[i]))
+            i++;
+        if (i < child->labelLength && rest[i]) return 0;
+        node = child;
+        rest += i;
+    }
+
+    int found = 0;
+    collectNameTrie(node, max, out, &found);
+    return found;
+}
+
+typedef struct
+{
+    const char *query;   // lowercased
+    int queryLength;
+    int maxEdits;
+    int *rows;           // edit-distance row per trie depth, queryLength + 1 each
+    int rowCapacity;     // rows allocated
+    int max;
+    NameMatch *out;
+    int found;
+} FuzzySearch;
+
+// func that keeps out sorted by distance, then name
+void offerFuzzyMatch(FuzzySearch *search, const NameTrieValue *value, int distance) {
+    int pos = search->found;
+    while (pos > 0 && (search->out[pos - 1].distance > distance ||
+                       (search->out[pos - 1].distance == distance &&
+                        strcmp(search->out[pos - 1].name, value->name) > 0)))
+        pos--;
+    if (pos >= search->max) return;
+
+    int last = search->found < search->max ? search->found : search->max - 1;
+    memmove(&search->out[pos + 1], &search->out[pos], sizeof(NameMatch) * (last - pos));
+    search->out[pos].name = value->name;
+    search->out[pos].item = value->item;
+    search->out[pos].distance = distance;
+    if (search->found < search->max) search->found++;
+}
+
+void fuzzyVisit(FuzzySearch *search, const NameTrieNode *node, int depth, int best) {
+    int width = search->queryLength + 1;
+    for (int i = 0; i < node->labelLength; i++) {
+        depth++;
+        if (depth >= search->rowCapacity) {
+            search->rowCapacity *= 2;
+            search->rows = (int *)realloc(search->rows, sizeof(int) * search->rowCapacity * width);
+            if (!search->rows) {
+                outPrintf("Memory allocation failed for name trie.\n");
+                exit(1);
+            }
+        }
+        int *prev = &search->rows[(depth - 1) * width];
+        int *row = &search->rows[depth * width];
+        row[0] = depth;
+        int rowMin = row[0];
+        for (int j = 1; j < width; j++) {
+            int cost = search->query[j - 1] == node->label[i] ? 0 : 1;
+            int value = prev[j - 1] + cost;
+            if (prev[j] + 1 < value) value = prev[j] + 1;
+            if (row[j - 1] + 1 < value) value = row[j - 1] + 1;
+            row[j] = value;
+            if (value < rowMin) rowMin = value;
+        }
+        if (row[width - 1] < best) best = row[width - 1];
+        // no longer name can come back within range
+        if (rowMin > search->maxEdits && best > search->maxEdits) return;
+    }
+
+    if (best <= search->maxEdits)
+        for (const NameTrieValue *value = node->values; value; value = value->next)
+            offerFuzzyMatch(search, value, best);
+    for (const NameTrieNode *child = node->child; child; child = child->sibling)
+        fuzzyVisit(search, child, depth, best);
+}
+
+int nameTrieFuzzy(const NameTrieNode *root, const char *query, int maxEdits, int max, NameMatch *out) {
+    if (max < 1 || maxEdits < 0) return 0;
+
+    char *folded = foldName(query);
+    FuzzySearch search;
+    search.query = folded;
+    search.queryLength = (int)strlen(folded);
+    search.maxEdits = maxEdits;
+    search.rowCapacity = 32;
+    search.rows = (int *)malloc(sizeof(int) * search.rowCapacity * (search.queryLength + 1));
+    if (!search.rows) {
+        outPrintf("Memory allocation failed for name trie.\n");
+        exit(1);
+    }
+    search.max = max;
+    search.out = out;
+    search.found = 0;
+
+    // row 0: turning the query into the empty string
+    for (int j = 0; j <= search.queryLength; j++)
+        search.rows[j] = j;
+    fuzzyVisit(&search, root, 0, search.queryLength);
+
+    free(search.rows);
+    free(folded);
+    return search.found;
+}
+
+void freeNameTrieChildren(NameTrieNode *node) {
+    NameTrieNode *child = node->child;
+    while (child) {
+        NameTrieNode *next = child->sibling;
+        freeNameTrieChildren(child);
+        freeNameTrieNode(child);
+        child = next;
+    }
+    node->child = NULL;
+}
+
+void freeNameTrie(NameTrieNode *root) {
+    freeNameTrieChildren(root);
+    while (root->values) {
+        NameTrieValue *next = root->values->next;
+        free(root->values);
+        root->values = next;
+    }
+}
+
+void buildSpeciesNameTrie() {
+    for (int i = 0; i < speciesCount; i++)
+        nameTrieInsert(&speciesNameTrie, speciesCatalog[i].name, &speciesCatalog[i]);
+}
 
-    ownerHead = NULL;
+void nameTrieOwnerLinked(OwnerNode *owner) {
+    pthread_rwlock_wrlock(&ownerNameTrieLock);
+    nameTrieInsert(&ownerNameTrie, owner->ownerName, owner);
+    pthread_rwlock_unlock(&ownerNameTrieLock);
 }
+
+void nameTrieOwnerUnlinked(OwnerNode *owner) {
+    pthread_rwlock_wrlock(&ownerNameTrieLock);
+    nameTrieRemove(&ownerNameTrie, owner->ownerName, owner);
+    pthread_rwlock_unlock(&ownerNameTrieLock);
+}
+
+void printNameMatches(const char *title, const NameMatch *matches, int count, int isSpecies) {
+    outPrintf("%s (%d):\n", title, count);
+    for (int i = 0; i < count; i++) {
+        if (isSpecies)
+            outPrintf("  %s (ID %d)", matches[i].name, ((const PokemonData *)matches[i].item)->id);
+        else
+            outPrintf("  %s", matches[i].name);
+        if (matches[i].distance > 0)
+            outPrintf(" [%d typo%s]", matches[i].distance, matches[i].distance == 1 ? "" : "s");
+        outPrintf("\n");
+    }
+}
+
+void autocompleteMenu() {
+    outPrintf("Enter the start of a name: ");
+    char *prefix = getDynamicInput();
+    if (!prefix) {
+        outPrintf("Invalid input.\n");
+        return;
+    }
+    int typos = readIntSafe("Typos allowed (0 = exact prefix): ");
+    if (typos < 0 || typos > AUTOCOMPLETE_MAX_TYPOS) {
+        outPrintf("Invalid choice.\n");
+        free(prefix);
+        return;
+    }
+
+    pthread_once(&speciesNameTrieOnce, buildSpeciesNameTrie);
+    NameMatch matches[AUTOCOMPLETE_MAX_MATCHES];
+    int found = typos == 0
+                    ? nameTrieComplete(&speciesNameTrie, prefix, AUTOCOMPLETE_MAX_MATCHES, matches)
+                    : nameTrieFuzzy(&speciesNameTrie, prefix, typos, AUTOCOMPLETE_MAX_MATCHES, matches);
+    printNameMatches("Pokemon", matches, found, 1);
+
+    pthread_rwlock_rdlock(&ownerNameTrieLock);
+    found = typos == 0
+                ? nameTrieComplete(&ownerNameTrie, prefix, AUTOCOMPLETE_MAX_MATCHES, matches)
+                : nameTrieFuzzy(&ownerNameTrie, prefix, typos, AUTOCOMPLETE_MAX_MATCHES, matches);
+    printNameMatches("Owners", matches, found, 0);
+    pthread_rwlock_unlock(&ownerNameTrieLock);
+
+    free(prefix);
+}
+
+// func that fills update[i] with the last node on level i sorting before owner
+void findDirectoryPath(const OwnerNode *owner, OwnerDirectoryNode **update) {
+    OwnerDirectoryNode *node = ownerDirectory;
+    for (int level = ownerDirectoryLevel - 1; level >= 0; level--) {
+        while (node->forward[level] && compareDirectoryOwners(node->forward[level]->owner, owner) < 0)
+            node = node->forward[level];
+        update[level] = node;
+    }
+}
+
+int randomDirectoryLevel() {
+    // xorshift32; each extra level with probability 1/2
+    ownerDirectorySeed ^= ownerDirectorySeed << 13;
+    ownerDirectorySeed ^= ownerDirectorySeed >> 17;
+    ownerDirectorySeed ^= ownerDirectorySeed << 5;
+    int level = 1;
+    unsigned int bits = ownerDirectorySeed;
+    while (level < OWNER_DIRECTORY_MAX_LEVEL && (bits & 1u)) {
+        level++;
+        bits >>= 1;
+    }
+    return level;
+}
+
+OwnerDirectoryNode *newDirectoryNode(OwnerNode *owner, int level) {
+    OwnerDirectoryNode *node = (OwnerDirectoryNode *)calloc(
+        1, sizeof(OwnerDirectoryNode) + sizeof(OwnerDirectoryNode *) * level);
+    if (!node) {
+        outPrintf("Memory allocation failed for owner directory.\n");
+        exit(1);
+    }
+    node->owner = owner;
+    node->level = level;
+    return node;
+}
+
+void directoryInsertOwner(OwnerNode *owner) {
+    pthread_rwlock_wrlock(&ownerDirectoryLock);
+    if (!ownerDirectory)
+        ownerDirectory = newDirectoryNode(NULL, OWNER_DIRECTORY_MAX_LEVEL);
+
+    OwnerDirectoryNode *update[OWNER_DIRECTORY_MAX_LEVEL];
+    findDirectoryPath(owner, update);
+    int level = randomDirectoryLevel();
+    for (int i = ownerDirectoryLevel; i < level; i++)
+        update[i] = ownerDirectory;
+    if (level > ownerDirectoryLevel) ownerDirectoryLevel = level;
+
+    OwnerDirectoryNode *node = newDirectoryNode(owner, level);
+    for (int i = 0; i < level; i++) {
+        node->forward[i] = update[i]->forward[i];
+        update[i]->forward[i] = node;
+    }
+    pthread_rwlock_unlock(&ownerDirectoryLock);
+}
+
+void directoryRemoveOwner(OwnerNode *owner) {
+    pthread_rwlock_wrlock(&ownerDirectoryLock);
+    if (!ownerDirectory) {
+        pthread_rwlock_unlock(&ownerDirectoryLock);
+        return;
+    }
+
+    OwnerDirectoryNode *update[OWNER_DIRECTORY_MAX_LEVEL];
+    findDirectoryPath(owner, update);
+    OwnerDirectoryNode *node = update[0]->forward[0];
+    if (node && node->owner == owner) {
+        for (int i = 0; i < node->level; i++)
+            update[i]->forward[i] = node->forward[i];
+        free(node);
+        while (ownerDirectoryLevel > 1 && !ownerDirectory->forward[ownerDirectoryLevel - 1])
+            ownerDirectoryLevel--;
+    }
+    pthread_rwlock_unlock(&ownerDirectoryLock);
+}
+
+OwnerNode *directoryPredecessor(OwnerNode *owner) {
+    pthread_rwlock_rdlock(&ownerDirectoryLock);
+    OwnerDirectoryNode *update[OWNER_DIRECTORY_MAX_LEVEL];
+    findDirectoryPath(owner, update);
+    OwnerNode *prev = update[0]->owner; // NULL for the sentinel
+    pthread_rwlock_unlock(&ownerDirectoryLock);
+    return prev;
+}
+
+void toggleDirectoryModeMenu() {
+    if (ownerDirectoryMode) {
+        ownerDirectoryMode = 0;
+        outPrintf("Sorted directory mode off. New owners join at the end.\n");
+        return;
+    }
+    // sort once; from then on every link keeps the ring sorted
+    pthread_mutex_lock(&ownerRingLock);
+    ownerDirectoryMode = 1;
+    pthread_mutex_unlock(&ownerRingLock);
+    outPrintf("Sorted directory mode on.\n");
+    sortOwners();
+}
+
+void freeOwnerDirectory() {
+    pthread_rwlock_wrlock(&ownerDirectoryLock);
+    while (ownerDirectory) {
+        OwnerDirectoryNode *next = ownerDirectory->forward[0];
+        free(ownerDirectory);
+        ownerDirectory = next;
+    }
+    ownerDirectoryLevel = 1;
+    pthread_rwlock_unlock(&ownerDirectoryLock);
+}
+
+unsigned int hashOwnerName(const char *name, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// func that finds or adds a long name in the intern table
+const char *internOwnerName(const char *name, int length, unsigned int hash) {
+    pthread_mutex_lock(&internLock);
+    InternedName **bucket = &internTable[hash % INTERN_TABLE_SIZE];
+    InternedName *entry = *bucket;
+    while (entry && !(entry->hash == hash && entry->length == length && memcmp(entry->text, name, length) == 0))
+        entry = entry->next;
+
+    if (entry) {
+        entry->refCount++;
+    } else {
+        entry = (InternedName *)malloc(sizeof(InternedName) + length + 1);
+        if (!entry) {
+            outPrintf("Memory allocation failed for owner name.\n");
+            exit(1);
+        }
+        entry->hash = hash;
+        entry->length = length;
+        entry->refCount = 1;
+        memcpy(entry->text, name, length + 1);
+        entry->next = *bucket;
+        *bucket = entry;
+    }
+    pthread_mutex_unlock(&internLock);
+    return entry->text;
+}
+
+void setOwnerName(OwnerNode *owner, const char *name) {
+    owner->nameLength = (int)strlen(name);
+    owner->nameHash = hashOwnerName(name, owner->nameLength);
+    if (owner->nameLength < OWNER_INLINE_NAME_SIZE) {
+        memcpy(owner->inlineName, name, owner->nameLength + 1);
+        owner->ownerName = owner->inlineName;
+    } else {
+        owner->ownerName = internOwnerName(name, owner->nameLength, owner->nameHash);
+    }
+}
+
+void clearOwnerName(OwnerNode *owner) {
+    if (owner->ownerName == owner->inlineName) return;
+
+    pthread_mutex_lock(&internLock);
+    InternedName **link = &internTable[owner->nameHash % INTERN_TABLE_SIZE];
+    while (*link && (*link)->text != owner->ownerName)
+        link = &(*link)->next;
+    if (*link && --(*link)->refCount == 0) {
+        InternedName *gone = *link;
+        *link = gone->next;
+        free(gone);
+    }
+    pthread_mutex_unlock(&internLock);
+    owner->ownerName = NULL;
+}
+
+int ownerNameEquals(const OwnerNode *owner, const char *name, int length, unsigned int hash) {
+    return owner->nameHash == hash && owner->nameLength == length &&
+           memcmp(owner->ownerName, name, length) == 0;
+}
+
+int readOwnerName(char *buffer) {
+    TRACE_SPAN();
+    int size = 0, fits = 1;
+    int c;
+    outFlush();
+    while ((c = getchar()) != '\n' && c != EOF) {
+        int isSpace = c == ' ' || c == '\t' || c == '\r';
+        if (size == 0 && isSpace) continue; // leading whitespace
+        if (size < OWNER_NAME_BUFFER_SIZE - 1) {
+            buffer[size++] = (char)c;
+        } else if (!isSpace) {
+            fits = 0; // trailing whitespace past the limit is fine
+        }
+    }
+    buffer[size] = '\0';
+    trimWhitespace(buffer);
+    return fits;
+}
+
+__thread TraceBuffer *traceThreadBuffer = NULL;
+
+void traceStart(void) {
+    const char *path = getenv(TRACE_ENV_VAR);
+    if (!path || !*path) return;
+
+    traceOutputPath = strdup(path);
+    if (!traceOutputPath) {
+        outPrintf("Memory allocation failed for trace path.\n");
+        exit(1);
+    }
+    traceEnabled = 1;
+}
+
+unsigned long long traceNowNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+}
+
+// func that finds (or registers) the calling thread's trace buffer
+TraceBuffer *traceBufferForThread(void) {
+    if (traceThreadBuffer) return traceThreadBuffer;
+
+    TraceBuffer *buffer = (TraceBuffer *)calloc(1, sizeof(TraceBuffer));
+    if (!buffer) {
+        outPrintf("Memory allocation failed for trace buffer.\n");
+        exit(1);
+    }
+    buffer->workerIndex = currentWorkerIndex;
+    pthread_mutex_lock(&traceLock);
+    buffer->threadId = ++traceThreadCount;
+    buffer->next = traceBuffers;
+    traceBuffers = buffer;
+    pthread_mutex_unlock(&traceLock);
+
+    traceThreadBuffer = buffer;
+    return buffer;
+}
+
+TraceSpan traceSpanBegin(const char *name, int arg) {
+    TraceSpan span = {name, 0, arg};
+    if (!traceEnabled) return span;
+
+    TraceBuffer *buffer = traceBufferForThread();
+    // a recursive call lives inside its caller's span
+    if (buffer->depth > 0 && buffer->open[buffer->depth - 1] == name) return span;
+    if (buffer->depth == TRACE_MAX_DEPTH) return span;
+
+    buffer->open[buffer->depth++] = name;
+    span.start = traceNowNs() | 1; // never 0, which means "not recorded"
+    return span;
+}
+
+void traceSpanEnd(TraceSpan *span) {
+    if (!span->start) return;
+
+    unsigned long long end = traceNowNs();
+    TraceBuffer *buffer = traceThreadBuffer;
+    buffer->depth--;
+
+    TraceEvent *event = &buffer->events[buffer->recorded % TRACE_BUFFER_CAPACITY];
+    event->name = span->name;
+    event->startNs = span->start;
+    event->durationNs = end > span->start ? end - span->start : 0;
+    event->arg = span->arg;
+    buffer->recorded++;
+}
+
+void traceDump(void) {
+    if (!traceEnabled) return;
+    traceEnabled = 0;
+
+    FILE *out = fopen(traceOutputPath, "w");
+    if (!out)
+        outPrintf("Could not write trace to %s.\n", traceOutputPath);
+
+    // timestamps are relative to the earliest recorded span
+    unsigned long long origin = 0;
+    for (TraceBuffer *buffer = traceBuffers; buffer; buffer = buffer->next) {
+        long long first = buffer->recorded > TRACE_BUFFER_CAPACITY ? buffer->recorded - TRACE_BUFFER_CAPACITY : 0;
+        if (buffer->recorded > first) {
+            unsigned long long start = buffer->events[first % TRACE_BUFFER_CAPACITY].startNs;
+            if (!origin || start < origin) origin = start;
+        }
+    }
+
+    if (out) fprintf(out, "{\"traceEvents\":[");
+    int written = 0;
+    while (traceBuffers) {
+        TraceBuffer *buffer = traceBuffers;
+        traceBuffers = buffer->next;
+        if (!out) {
+            free(buffer);
+            continue;
+        }
+
+        fprintf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,", written++ ? "," : "", buffer->threadId);
+        if (buffer->workerIndex < 0)
+            fprintf(out, "\"args\":{\"name\":\"main\"}}");
+        else
+            fprintf(out, "\"args\":{\"name\":\"worker %d\"}}", buffer->workerIndex);
+
+        long long first = buffer->recorded > TRACE_BUFFER_CAPACITY ? buffer->recorded - TRACE_BUFFER_CAPACITY : 0;
+        for (long long i = first; i < buffer->recorded; i++) {
+            TraceEvent *event = &buffer->events[i % TRACE_BUFFER_CAPACITY];
+            fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    event->name, buffer->threadId,
+                    (event->startNs - origin) / 1000.0, event->durationNs / 1000.0);
+            if (event->arg >= 0)
+                fprintf(out, ",\"args\":{\"choice\":%d}", event->arg);
+            fprintf(out, "}");
+        }
+        free(buffer);
+    }
+    if (out) {
+        fprintf(out, "\n]}\n");
+        fclose(out);
+    }
+
+    free(traceOutputPath);
+    traceOutputPath = NULL;
+}
+
+// set on the thread that called outStart; only it may append to the ring
+__thread int outputIsProducer = 0;
+
+void *outputWriterMain(void *arg) {
+    (void)arg;
+    for (;;) {
+        unsigned long head = __atomic_load_n(&outputHead, __ATOMIC_SEQ_CST);
+        unsigned long tail = outputTail;
+        if (head != tail) {
+            // coalesce everything queued so far into one or two writes
+            size_t start = tail & (OUTPUT_RING_SIZE - 1);
+            size_t length = head - tail;
+            size_t first = length < OUTPUT_RING_SIZE - start ? length : OUTPUT_RING_SIZE - start;
+            fwrite(outputRing + start, 1, first, stdout);
+            if (length > first)
+                fwrite(outputRing, 1, length - first, stdout);
+            fflush(stdout);
+
+            __atomic_store_n(&outputTail, head, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&outputProducerWaiting, __ATOMIC_SEQ_CST)) {
+                pthread_mutex_lock(&outputLock);
+                pthread_cond_broadcast(&outputDrained);
+                pthread_mutex_unlock(&outputLock);
+            }
+            continue;
+        }
+        if (__atomic_load_n(&outputStopping, __ATOMIC_SEQ_CST)) break;
+
+        // announce the nap before re-checking, so a producer either sees it or we see its bytes
+        pthread_mutex_lock(&outputLock);
+        __atomic_store_n(&outputWriterIdle, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&outputHead, __ATOMIC_SEQ_CST) == outputTail &&
+               !__atomic_load_n(&outputStopping, __ATOMIC_SEQ_CST))
+            pthread_cond_wait(&outputReady, &outputLock);
+        __atomic_store_n(&outputWriterIdle, 0, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&outputLock);
+    }
+    return NULL;
+}
+
+void outStart(void) {
+    if (outputStarted) return;
+    if (pthread_create(&outputWriter, NULL, outputWriterMain, NULL) != 0)
+        return; // stay synchronous
+    outputIsProducer = 1;
+    outputStarted = 1;
+    atexit(outFlush); // exit(1) paths still see their last message
+}
+
+void outStop(void) {
+    if (!outputStarted || !outputIsProducer) return;
+
+    outFlush();
+    pthread_mutex_lock(&outputLock);
+    __atomic_store_n(&outputStopping, 1, __ATOMIC_SEQ_CST);
+    pthread_cond_signal(&outputReady);
+    pthread_mutex_unlock(&outputLock);
+    pthread_join(outputWriter, NULL);
+    outputStarted = 0;
+}
+
+// func that sleeps until the writer's tail reaches target
+void outputWaitForTail(unsigned long target) {
+    if (__atomic_load_n(&outputTail, __ATOMIC_SEQ_CST) >= target) return;
+
+    pthread_mutex_lock(&outputLock);
+    __atomic_add_fetch(&outputProducerWaiting, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&outputTail, __ATOMIC_SEQ_CST) < target)
+        pthread_cond_wait(&outputDrained, &outputLock);
+    __atomic_sub_fetch(&outputProducerWaiting, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&outputLock);
+}
+
+void outWrite(const char *data, size_t length) {
+    if (!outputStarted || !outputIsProducer) {
+        // other threads (or no writer): keep the order by draining first
+        outFlush();
+        fwrite(data, 1, length, stdout);
+        fflush(stdout);
+        return;
+    }
+
+    unsigned long head = outputHead;
+    while (length > 0) {
+        // backpressure: wait for at least one free byte
+        if (head - __atomic_load_n(&outputTail, __ATOMIC_SEQ_CST) == OUTPUT_RING_SIZE)
+            outputWaitForTail(head - OUTPUT_RING_SIZE + 1);
+        size_t space = OUTPUT_RING_SIZE - (head - __atomic_load_n(&outputTail, __ATOMIC_SEQ_CST));
+        size_t start = head & (OUTPUT_RING_SIZE - 1);
+        size_t chunk = length;
+        if (chunk > space) chunk = space;
+        if (chunk > OUTPUT_RING_SIZE - start) chunk = OUTPUT_RING_SIZE - start;
+
+        memcpy(outputRing + start, data, chunk);
+        data += chunk;
+        length -= chunk;
+        head += chunk;
+        __atomic_store_n(&outputHead, head, __ATOMIC_SEQ_CST);
+
+        if (__atomic_load_n(&outputWriterIdle, __ATOMIC_SEQ_CST)) {
+            pthread_mutex_lock(&outputLock);
+            pthread_cond_signal(&outputReady);
+            pthread_mutex_unlock(&outputLock);
+        }
+    }
+}
+
+int outPrintf(const char *format, ...) {
+    char stackBuffer[OUTPUT_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+    va_end(args);
+    if (length < 0) return length;
+
+    if ((size_t)length < sizeof(stackBuffer)) {
+        outWrite(stackBuffer, (size_t)length);
+        return length;
+    }
+
+    // rare long message: format again into the heap
+    char *heapBuffer = (char *)malloc((size_t)length + 1);
+    if (!heapBuffer) {
+        fputs("Memory allocation failed for output.\n", stderr);
+        exit(1);
+    }
+    va_start(args, format);
+    vsnprintf(heapBuffer, (size_t)length + 1, format, args);
+    va_end(args);
+    outWrite(heapBuffer, (size_t)length);
+    free(heapBuffer);
+    return length;
+}
+
+void outFlush(void) {
+    if (!outputStarted) {
+        fflush(stdout);
+        return;
+    }
+    outputWaitForTail(__atomic_load_n(&outputHead, __ATOMIC_SEQ_CST));
+}
+
+typedef struct
+{
+    PokemonType attacker;
+    PokemonType defender;
+    double multiplier;
+} TypeMatchup;
+
+// every pairing that isn't neutral
+static const TypeMatchup typeMatchups[] = {
+    {NORMAL, ROCK, 0.5}, {NORMAL, GHOST, 0.0},
+    {FIRE, GRASS, 2.0}, {FIRE, ICE, 2.0}, {FIRE, BUG, 2.0},
+    {FIRE, FIRE, 0.5}, {FIRE, WATER, 0.5}, {FIRE, ROCK, 0.5}, {FIRE, DRAGON, 0.5},
+    {WATER, FIRE, 2.0}, {WATER, GROUND, 2.0}, {WATER, ROCK, 2.0},
+    {WATER, WATER, 0.5}, {WATER, GRASS, 0.5}, {WATER, DRAGON, 0.5},
+    {ELECTRIC, WATER, 2.0},
+    {ELECTRIC, ELECTRIC, 0.5}, {ELECTRIC, GRASS, 0.5}, {ELECTRIC, DRAGON, 0.5}, {ELECTRIC, GROUND, 0.0},
+    {GRASS, WATER, 2.0}, {GRASS, GROUND, 2.0}, {GRASS, ROCK, 2.0},
+    {GRASS, FIRE, 0.5}, {GRASS, GRASS, 0.5}, {GRASS, POISON, 0.5}, {GRASS, BUG, 0.5}, {GRASS, DRAGON, 0.5},
+    {ICE, GRASS, 2.0}, {ICE, GROUND, 2.0}, {ICE, DRAGON, 2.0},
+    {ICE, FIRE, 0.5}, {ICE, WATER, 0.5}, {ICE, ICE, 0.5},
+    {FIGHTING, NORMAL, 2.0}, {FIGHTING, ICE, 2.0}, {FIGHTING, ROCK, 2.0},
+    {FIGHTING, POISON, 0.5}, {FIGHTING, BUG, 0.5}, {FIGHTING, PSYCHIC, 0.5}, {FIGHTING, FAIRY, 0.5},
+    {FIGHTING, GHOST, 0.0},
+    {POISON, GRASS, 2.0}, {POISON, FAIRY, 2.0},
+    {POISON, POISON, 0.5}, {POISON, GROUND, 0.5}, {POISON, ROCK, 0.5}, {POISON, GHOST, 0.5},
+    {GROUND, FIRE, 2.0}, {GROUND, ELECTRIC, 2.0}, {GROUND, POISON, 2.0}, {GROUND, ROCK, 2.0},
+    {GROUND, GRASS, 0.5}, {GROUND, BUG, 0.5},
+    {PSYCHIC, FIGHTING, 2.0}, {PSYCHIC, POISON, 2.0}, {PSYCHIC, PSYCHIC, 0.5},
+    {BUG, GRASS, 2.0}, {BUG, PSYCHIC, 2.0},
+    {BUG, FIRE, 0.5}, {BUG, FIGHTING, 0.5}, {BUG, POISON, 0.5}, {BUG, GHOST, 0.5}, {BUG, FAIRY, 0.5},
+    {ROCK, FIRE, 2.0}, {ROCK, ICE, 2.0}, {ROCK, BUG, 2.0}, {ROCK, FIGHTING, 0.5}, {ROCK, GROUND, 0.5},
+    {GHOST, PSYCHIC, 2.0}, {GHOST, GHOST, 2.0}, {GHOST, NORMAL, 0.0},
+    {DRAGON, DRAGON, 2.0}, {DRAGON, FAIRY, 0.0},
+    {FAIRY, FIGHTING, 2.0}, {FAIRY, DRAGON, 2.0}, {FAIRY, FIRE, 0.5}, {FAIRY, POISON, 0.5},
+};
+
+void buildTypeEffectiveness(void) {
+    for (int a = 0; a < POKEMON_TYPE_COUNT; a++)
+        for (int d = 0; d < POKEMON_TYPE_COUNT; d++)
+            typeEffectiveness[a][d] = 1.0;
+    for (size_t i = 0; i < sizeof(typeMatchups) / sizeof(typeMatchups[0]); i++)
+        typeEffectiveness[typeMatchups[i].attacker][typeMatchups[i].defender] = typeMatchups[i].multiplier;
+}
+
+// func that returns a uniform double in [0, 1) (xorshift64*)
+double battleRandom(unsigned long long *rng) {
+    *rng ^= *rng >> 12;
+    *rng ^= *rng << 25;
+    *rng ^= *rng >> 27;
+    return ((*rng * 2685821657736338717ull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// func that turns a batch number into an independent, nonzero seed (splitmix64)
+unsigned long long battleSeedFor(unsigned long long base, unsigned long long index) {
+    unsigned long long z = base + (index + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return z ? z : 1;
+}
+
+// func that rolls one attack's damage
+double battleHit(const PokemonData *attacker, const PokemonData *defender, unsigned long long *rng) {
+    if (battleRandom(rng) >= BATTLE_HIT_CHANCE) return 0.0;
+
+    double damage = attacker->attack * BATTLE_DAMAGE_SCALE *
+                    typeEffectiveness[attacker->TYPE][defender->TYPE];
+    damage *= BATTLE_MIN_ROLL + (1.0 - BATTLE_MIN_ROLL) * battleRandom(rng);
+    if (battleRandom(rng) < BATTLE_CRIT_CHANCE) damage *= BATTLE_CRIT_MULTIPLIER;
+    return damage;
+}
+
+int simulateBattle(const PokemonData *first, const PokemonData *second, unsigned long long *rng) {
+    double hp[2] = {first->hp, second->hp};
+    const PokemonData *fighters[2] = {first, second};
+
+    // a coin flip decides who moves first
+    int turn = battleRandom(rng) < 0.5 ? 0 : 1;
+    for (int i = 0; i < BATTLE_MAX_TURNS; i++) {
+        int other = 1 - turn;
+        hp[other] -= battleHit(fighters[turn], fighters[other], rng);
+        if (hp[other] <= 0) return turn + 1;
+        turn = other;
+    }
+    return 0;
+}
+
+void simulateMatchup(const PokemonData *first, const PokemonData *second, long long trials,
+                     unsigned long long seed, BattleTally *tally) {
+    pthread_once(&typeEffectivenessOnce, buildTypeEffectiveness);
+
+    unsigned long long rng = seed ? seed : 1;
+    tally->firstWins = tally->secondWins = tally->ties = 0;
+    for (long long i = 0; i < trials; i++) {
+        int winner = simulateBattle(first, second, &rng);
+        if (winner == 1)
+            tally->firstWins++;
+        else if (winner == 2)
+            tally->secondWins++;
+        else
+            tally->ties++;
+    }
+}
+
+// One pool task: a batch of battles between first and each of seconds
+typedef struct
+{
+    const PokemonData *first;
+    const PokemonData **seconds;
+    int secondCount;
+    long long trials;            // per matchup
+    unsigned long long seed;
+    BattleTally *tallies;        // one per second
+} BattleTask;
+
+void battleTaskMain(void *arg) {
+    BattleTask *task = (BattleTask *)arg;
+    for (int i = 0; i < task->secondCount; i++)
+        simulateMatchup(task->first, task->seconds[i], task->trials,
+                        battleSeedFor(task->seed, (unsigned long long)i), &task->tallies[i]);
+}
+
+// func that takes the next seed for a simulation
+unsigned long long nextBattleSeed(void) {
+    battleSeed = battleSeedFor(battleSeed, 0);
+    return battleSeed;
+}
+
+void battleSimulationMenu(OwnerNode *owner) {
+    lockOwnerRead(owner);
+    int isEmpty = owner->pokedexRoot == NULL;
+    unlockOwner(owner);
+    if (isEmpty) {
+        outPrintf("Pokedex is empty.\n");
+        return;
+    }
+
+    outPrintf("Enter ID of the first Pokemon: ");
+    int id1 = readPokemonIDSafe("");
+    outPrintf("Enter ID of the second Pokemon: ");
+    int id2 = readPokemonIDSafe("");
+
+    // species data lives in the catalog, so no lock is needed once found
+    lockOwnerRead(owner);
+    const PokemonData *first = findOwnedPokemon(owner, id1);
+    const PokemonData *second = findOwnedPokemon(owner, id2);
+    unlockOwner(owner);
+    if (!first || !second) {
+        outPrintf("One or both Pokemon IDs not found.\n");
+        return;
+    }
+
+    // split the trials into independent batches, each with its own RNG
+    int taskCount = BATTLE_TRIALS / BATTLE_TRIALS_PER_TASK;
+    BattleTask *tasks = (BattleTask *)malloc(sizeof(BattleTask) * taskCount);
+    BattleTally *tallies = (BattleTally *)malloc(sizeof(BattleTally) * taskCount);
+    if (!tasks || !tallies) {
+        outPrintf("Memory allocation failed for battle simulation.\n");
+        exit(1);
+    }
+    unsigned long long seed = nextBattleSeed();
+    TaskPool *pool = getTaskPool();
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].first = first;
+        tasks[i].seconds = &second;
+        tasks[i].secondCount = 1;
+        tasks[i].trials = BATTLE_TRIALS_PER_TASK;
+        tasks[i].seed = battleSeedFor(seed, (unsigned long long)i);
+        tasks[i].tallies = &tallies[i];
+        submitTask(pool, battleTaskMain, &tasks[i]);
+    }
+    waitTaskPool(pool);
+
+    BattleTally total = {0, 0, 0};
+    for (int i = 0; i < taskCount; i++) {
+        total.firstWins += tallies[i].firstWins;
+        total.secondWins += tallies[i].secondWins;
+        total.ties += tallies[i].ties;
+    }
+    free(tasks);
+    free(tallies);
+
+    double trials = (double)taskCount * BATTLE_TRIALS_PER_TASK;
+    outPrintf("%s (%s) vs %s (%s), %.0f battles:\n", first->name, getTypeName(first->TYPE),
+              second->name, getTypeName(second->TYPE), trials);
+    outPrintf("Type effectiveness: %.1fx / %.1fx\n",
+              typeEffectiveness[first->TYPE][second->TYPE], typeEffectiveness[second->TYPE][first->TYPE]);
+    outPrintf("%s wins %.1f%%\n", first->name, 100.0 * total.firstWins / trials);
+    outPrintf("%s wins %.1f%%\n", second->name, 100.0 * total.secondWins / trials);
+    outPrintf("Ties %.1f%%\n", 100.0 * total.ties / trials);
+}
+
+// func that copies an owner's species pointers in ID order (caller holds its lock)
+const PokemonData **collectOwnerSpecies(OwnerNode *owner, int *count) {
+    NodeArray nodes;
+    initNodeArray(&nodes, INITIAL_NODE_ARRAY_CAPACITY);
+    collectAll(owner->pokedexRoot, &nodes);
+
+    const PokemonData **species = (const PokemonData **)malloc(sizeof(PokemonData *) * (nodes.size + 1));
+    if (!species) {
+        outPrintf("Memory allocation failed for battle simulation.\n");
+        exit(1);
+    }
+    for (int i = 0; i < nodes.size; i++)
+        species[i] = pokemonData(nodes.nodes[i]);
+    *count = nodes.size;
+    free(nodes.nodes);
+    return species;
+}
+
+void ownerBattleMenu() {
+    // both owners are pinned between prompts instead of holding a read section open
+    unsigned long epoch = ringReadBegin();
+    int linked = countLinkedOwners();
+    ringReadEnd(epoch);
+    if (linked < 2) {
+        outPrintf("Not enough owners to battle.\n");
+        return;
+    }
+
+    char firstName[OWNER_NAME_BUFFER_SIZE];
+    char secondName[OWNER_NAME_BUFFER_SIZE];
+    outPrintf("Enter name of first owner: ");
+    OwnerNode *firstOwner = readOwnerName(firstName) ? findAndPinOwner(firstName) : NULL;
+    outPrintf("Enter name of second owner: ");
+    OwnerNode *secondOwner = readOwnerName(secondName) ? findAndPinOwner(secondName) : NULL;
+    if (!firstOwner || !secondOwner) {
+        outPrintf("One or both owners not found.\n");
+        unpinOwner(firstOwner);
+        unpinOwner(secondOwner);
+        return;
+    }
+
+    // snapshot both teams, then simulate without holding any lock
+    int firstCount, secondCount;
+    lockOwnerRead(firstOwner);
+    const PokemonData **firstTeam = collectOwnerSpecies(firstOwner, &firstCount);
+    unlockOwner(firstOwner);
+    lockOwnerRead(secondOwner);
+    const PokemonData **secondTeam = collectOwnerSpecies(secondOwner, &secondCount);
+    unlockOwner(secondOwner);
+    if (firstCount == 0 || secondCount == 0) {
+        outPrintf("Both Pokedexes need at least one Pokemon.\n");
+        free(firstTeam);
+        free(secondTeam);
+        unpinOwner(firstOwner);
+        unpinOwner(secondOwner);
+        return;
+    }
+
+    // one task per Pokemon of the first owner, against the whole second team
+    BattleTask *tasks = (BattleTask *)malloc(sizeof(BattleTask) * firstCount);
+    BattleTally *tallies = (BattleTally *)malloc(sizeof(BattleTally) * firstCount * secondCount);
+    if (!tasks || !tallies) {
+        outPrintf("Memory allocation failed for battle simulation.\n");
+        exit(1);
+    }
+    unsigned long long seed = nextBattleSeed();
+    TaskPool *pool = getTaskPool();
+    for (int i = 0; i < firstCount; i++) {
+        tasks[i].first = firstTeam[i];
+        tasks[i].seconds = secondTeam;
+        tasks[i].secondCount = secondCount;
+        tasks[i].trials = BATTLE_TRIALS_PER_MATCHUP;
+        tasks[i].seed = battleSeedFor(seed, (unsigned long long)i);
+        tasks[i].tallies = &tallies[(size_t)i * secondCount];
+        submitTask(pool, battleTaskMain, &tasks[i]);
+    }
+    waitTaskPool(pool);
+
+    outPrintf("%s vs %s: %d matchups, %d battles each.\n", firstOwner->ownerName,
+              secondOwner->ownerName, firstCount * secondCount, BATTLE_TRIALS_PER_MATCHUP);
+    BattleTally total = {0, 0, 0};
+    for (int i = 0; i < firstCount; i++) {
+        long long wins = 0;
+        for (int j = 0; j < secondCount; j++) {
+            BattleTally *tally = &tallies[(size_t)i * secondCount + j];
+            wins += tally->firstWins;
+            total.firstWins += tally->firstWins;
+            total.secondWins += tally->secondWins;
+            total.ties += tally->ties;
+        }
+        outPrintf("%s: wins %.1f%% against %s's Pokedex\n", firstTeam[i]->name,
+                  100.0 * wins / ((double)secondCount * BATTLE_TRIALS_PER_MATCHUP), secondOwner->ownerName);
+    }
+    double battles = (double)firstCount * secondCount * BATTLE_TRIALS_PER_MATCHUP;
+    outPrintf("%s wins %.1f%%, %s wins %.1f%%, ties %.1f%%\n",
+              firstOwner->ownerName, 100.0 * total.firstWins / battles,
+              secondOwner->ownerName, 100.0 * total.secondWins / battles,
+              100.0 * total.ties / battles);
+
+    unpinOwner(firstOwner);
+    unpinOwner(secondOwner);
+    free(tasks);
+    free(tallies);
+    free(firstTeam);
+    free(secondTeam);
+}
+
+// One pool task: fill a row of the win-chance matrix
+typedef struct
+{
+    const PokemonData *candidate;
+    const PokemonData **opponents;
+    int opponentCount;
+    unsigned long long seed;
+    float *row;
+} WinChanceTask;
+
+void winChanceTaskMain(void *arg) {
+    WinChanceTask *task = (WinChanceTask *)arg;
+    for (int j = 0; j < task->opponentCount; j++) {
+        BattleTally tally;
+        simulateMatchup(task->candidate, task->opponents[j], TEAM_TRIALS_PER_MATCHUP,
+                        battleSeedFor(task->seed, (unsigned long long)j), &tally);
+        // a tie counts as half a win
+        task->row[j] = (float)((tally.firstWins + 0.5 * tally.ties) / TEAM_TRIALS_PER_MATCHUP);
+    }
+}
+
+// func that offers a finished team to the shared best
+void offerTeam(TeamSearch *search, const int *team, double score) {
+    pthread_mutex_lock(&search->lock);
+    if (score > search->bestScore + TEAM_SCORE_EPSILON) {
+        memcpy(search->bestTeam, team, sizeof(int) * search->teamSize);
+        __atomic_store(&search->bestScore, &score, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&search->lock);
+}
+
+// A candidate and what adding it to the current team would add
+typedef struct
+{
+    double gain;
+    int index;
+} TeamCandidate;
+
+int compareTeamCandidates(const void *a, const void *b) {
+    const TeamCandidate *candidateA = (const TeamCandidate *)a;
+    const TeamCandidate *candidateB = (const TeamCandidate *)b;
+    if (candidateA->gain != candidateB->gain) return candidateA->gain < candidateB->gain ? 1 : -1;
+    return candidateA->index - candidateB->index;
+}
+
+// Per-thread scratch of the depth-first search
+typedef struct
+{
+    TeamSearch *search;
+    int team[TEAM_SIZE];
+    float *cover;                 // cover[depth * opponentCount + j]: best win chance on opponent j so far
+    TeamCandidate *candidates;    // candidates[depth * candidateCount + i]: this depth's choices, best gain first
+} TeamFrame;
+
+// func that extends the team at depth from the given candidates; cover of depth is current
+void searchTeamFrom(TeamFrame *frame, int depth, const TeamCandidate *allowed, int allowedCount, double score) {
+    TeamSearch *search = frame->search;
+    int m = search->opponentCount;
+    int remaining = search->teamSize - depth;
+
+    if (__atomic_add_fetch(&search->nodes, 1, __ATOMIC_RELAXED) > TEAM_SEARCH_NODE_LIMIT) {
+        __atomic_store_n(&search->stoppedEarly, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (remaining == 0) {
+        offerTeam(search, frame->team, score);
+        return;
+    }
+
+    // marginal gain of every allowed candidate, best first
+    const float *cover = frame->cover + (size_t)depth * m;
+    TeamCandidate *choices = frame->candidates + (size_t)depth * search->candidateCount;
+    for (int i = 0; i < allowedCount; i++) {
+        const float *row = search->winChance + (size_t)allowed[i].index * m;
+        double gain = 0;
+        for (int j = 0; j < m; j++)
+            if (row[j] > cover[j]) gain += row[j] - cover[j];
+        choices[i].gain = gain;
+        choices[i].index = allowed[i].index;
+    }
+    qsort(choices, allowedCount, sizeof(TeamCandidate), compareTeamCandidates);
+
+    // child i may only add choices after it, so its best case is the next
+    // `remaining` gains (gains only shrink as the team grows); that bound
+    // falls with i, so the first child that can't win ends the loop
+    double window = 0;
+    for (int i = 0; i < remaining && i < allowedCount; i++)
+        window += choices[i].gain;
+    for (int i = 0; i + remaining <= allowedCount; i++) {
+        if (i > 0) {
+            window -= choices[i - 1].gain;
+            window += choices[i + remaining - 1].gain;
+        }
+        double best;
+        __atomic_load(&search->bestScore, &best, __ATOMIC_RELAXED);
+        if (score + window <= best + TEAM_SCORE_EPSILON) break;
+        if (__atomic_load_n(&search->stoppedEarly, __ATOMIC_RELAXED)) break;
+
+        const float *row = search->winChance + (size_t)choices[i].index * m;
+        float *next = frame->cover + (size_t)(depth + 1) * m;
+        for (int j = 0; j < m; j++)
+            next[j] = row[j] > cover[j] ? row[j] : cover[j];
+        frame->team[depth] = choices[i].index;
+        searchTeamFrom(frame, depth + 1, choices + i + 1, allowedCount - i - 1, score + choices[i].gain);
+    }
+}
+
+typedef struct
+{
+    TeamSearch *search;
+    const TeamCandidate *order;   // every candidate by solo score, best first
+    int position;                 // this task's first member within order
+} TeamTask;
+
+void teamTaskMain(void *arg) {
+    TeamTask *task = (TeamTask *)arg;
+    TeamSearch *search = task->search;
+    int n = search->candidateCount, m = search->opponentCount;
+
+    TeamFrame frame;
+    frame.search = search;
+    frame.cover = (float *)malloc(sizeof(float) * (search->teamSize + 1) * m);
+    frame.candidates = (TeamCandidate *)malloc(sizeof(TeamCandidate) * (search->teamSize + 1) * n);
+    if (!frame.cover || !frame.candidates) {
+        outPrintf("Memory allocation failed for team search.\n");
+        exit(1);
+    }
+
+    int first = task->order[task->position].index;
+    frame.team[0] = first;
+    const float *row = search->winChance + (size_t)first * m;
+    for (int j = 0; j < m; j++)
+        frame.cover[m + j] = row[j];
+    searchTeamFrom(&frame, 1, task->order + task->position + 1, n - task->position - 1,
+                   task->order[task->position].gain);
+    free(frame.cover);
+    free(frame.candidates);
+}
+
+void searchBestTeam(TeamSearch *search) {
+    int n = search->candidateCount, m = search->opponentCount, k = search->teamSize;
+    search->nodes = 0;
+    search->stoppedEarly = 0;
+    pthread_mutex_init(&search->lock, NULL);
+
+    // greedy team first: a good score to prune against from the start
+    float *cover = (float *)calloc(m, sizeof(float));
+    TeamCandidate *order = (TeamCandidate *)malloc(sizeof(TeamCandidate) * n);
+    TeamTask *tasks = (TeamTask *)malloc(sizeof(TeamTask) * n);
+    if (!cover || !order || !tasks) {
+        outPrintf("Memory allocation failed for team search.\n");
+        exit(1);
+    }
+    double score = 0;
+    for (int t = 0; t < k; t++) {
+        int pick = -1;
+        double pickGain = -1;
+        for (int c = 0; c < n; c++) {
+            int taken = 0;
+            for (int u = 0; u < t; u++)
+                if (search->bestTeam[u] == c) taken = 1;
+            if (taken) continue;
+            const float *row = search->winChance + (size_t)c * m;
+            double gain = 0;
+            for (int j = 0; j < m; j++)
+                if (row[j] > cover[j]) gain += row[j] - cover[j];
+            if (gain > pickGain) {
+                pickGain = gain;
+                pick = c;
+            }
+        }
+        search->bestTeam[t] = pick;
+        score += pickGain;
+        const float *row = search->winChance + (size_t)pick * m;
+        for (int j = 0; j < m; j++)
+            if (row[j] > cover[j]) cover[j] = row[j];
+    }
+    search->bestScore = score;
+    free(cover);
+
+    // then branch-and-bound, one task per first member, strongest first
+    for (int c = 0; c < n; c++) {
+        const float *row = search->winChance + (size_t)c * m;
+        order[c].index = c;
+        order[c].gain = 0;
+        for (int j = 0; j < m; j++)
+            order[c].gain += row[j];
+    }
+    qsort(order, n, sizeof(TeamCandidate), compareTeamCandidates);
+
+    TaskPool *pool = getTaskPool();
+    for (int i = 0; i + k <= n; i++) {
+        tasks[i].search = search;
+        tasks[i].order = order;
+        tasks[i].position = i;
+        submitTask(pool, teamTaskMain, &tasks[i]);
+    }
+    waitTaskPool(pool);
+    free(tasks);
+    free(order);
+    pthread_mutex_destroy(&search->lock);
+}
+
+void teamOptimizerMenu() {
+    // both owners are pinned between prompts instead of holding a read section open
+    unsigned long epoch = ringReadBegin();
+    int linked = countLinkedOwners();
+    ringReadEnd(epoch);
+    if (linked < 2) {
+        outPrintf("Not enough owners to compare.\n");
+        return;
+    }
+
+    char ownerName[OWNER_NAME_BUFFER_SIZE];
+    char opponentName[OWNER_NAME_BUFFER_SIZE];
+    outPrintf("Enter name of the owner picking a team: ");
+    OwnerNode *owner = readOwnerName(ownerName) ? findAndPinOwner(ownerName) : NULL;
+    outPrintf("Enter name of the opponent: ");
+    OwnerNode *opponent = readOwnerName(opponentName) ? findAndPinOwner(opponentName) : NULL;
+    if (!owner || !opponent) {
+        outPrintf("One or both owners not found.\n");
+        unpinOwner(owner);
+        unpinOwner(opponent);
+        return;
+    }
+
+    int candidateCount, opponentCount;
+    lockOwnerRead(owner);
+    const PokemonData **candidates = collectOwnerSpecies(owner, &candidateCount);
+    unlockOwner(owner);
+    lockOwnerRead(opponent);
+    const PokemonData **opponents = collectOwnerSpecies(opponent, &opponentCount);
+    unlockOwner(opponent);
+    if (candidateCount == 0 || opponentCount == 0) {
+        outPrintf("Both Pokedexes need at least one Pokemon.\n");
+        free(candidates);
+        free(opponents);
+        unpinOwner(owner);
+        unpinOwner(opponent);
+        return;
+    }
+
+    // 1) every pairwise win chance once, one matrix row per pool task
+    float *winChance = (float *)malloc(sizeof(float) * candidateCount * opponentCount);
+    WinChanceTask *rows = (WinChanceTask *)malloc(sizeof(WinChanceTask) * candidateCount);
+    if (!winChance || !rows) {
+        outPrintf("Memory allocation failed for team search.\n");
+        exit(1);
+    }
+    unsigned long long seed = nextBattleSeed();
+    TaskPool *pool = getTaskPool();
+    for (int i = 0; i < candidateCount; i++) {
+        rows[i].candidate = candidates[i];
+        rows[i].opponents = opponents;
+        rows[i].opponentCount = opponentCount;
+        rows[i].seed = battleSeedFor(seed, (unsigned long long)i);
+        rows[i].row = winChance + (size_t)i * opponentCount;
+        submitTask(pool, winChanceTaskMain, &rows[i]);
+    }
+    waitTaskPool(pool);
+
+    // 2) branch-and-bound over teams, reading only the matrix
+    TeamSearch search;
+    search.winChance = winChance;
+    search.candidateCount = candidateCount;
+    search.opponentCount = opponentCount;
+    search.teamSize = candidateCount < TEAM_SIZE ? candidateCount : TEAM_SIZE;
+    searchBestTeam(&search);
+
+    outPrintf("Best team of %d for %s against %s's Pokedex:\n", search.teamSize,
+              owner->ownerName, opponent->ownerName);
+    for (int t = 0; t < search.teamSize; t++) {
+        const PokemonData *member = candidates[search.bestTeam[t]];
+        outPrintf("- %s (%s)\n", member->name, getTypeName(member->TYPE));
+    }
+    outPrintf("Expected to beat %.1f of %d opponents (%.1f%%).\n", search.bestScore, opponentCount,
+              100.0 * search.bestScore / opponentCount);
+    if (search.stoppedEarly)
+        outPrintf("Search stopped after %lld nodes; this is the best team found.\n", (long long)TEAM_SEARCH_NODE_LIMIT);
+
+    unpinOwner(owner);
+    unpinOwner(opponent);
+    free(winChance);
+    free(rows);
+    free(candidates);
+    free(opponents);
+}
+
 // practically the main menu func
 void mainMenu() {
     int choice;
     do {
-        printf("\n=== Main Menu ===\n");
-        printf("1. New Pokedex\n");
-        printf("2. Existing Pokedex\n");
-        printf("3. Delete a Pokedex\n");
-        printf("4. Merge Pokedexes\n");
-        printf("5. Sort Owners by Name\n");
-        printf("6. Print Owners in a direction X times\n");
-        printf("7. Exit\n");
+        outPrintf("\n=== Main Menu ===\n");
+        outPrintf("1. New Pokedex\n");
+        outPrintf("2. Existing Pokedex\n");
+        outPrintf("3. Delete a Pokedex\n");
+        outPrintf("4. Merge Pokedexes\n");
+        outPrintf("5. Sort Owners by Name\n");
+        outPrintf("6. Print Owners in a direction X times\n");
+        outPrintf("7. Exit\n");
+        outPrintf("8. Merge Many Pokedexes\n");
+        outPrintf("9. Who Has Pokemon?\n");
+        outPrintf("10. Global Top Pokemon\n");
+        outPrintf("11. Scan Species Catalog\n");
+        outPrintf("12. Clone Pokedex\n");
+        outPrintf("13. Undo\n");
+        outPrintf("14. Redo\n");
+        outPrintf("15. Autocomplete Names\n");
+        outPrintf("16. Toggle Sorted Directory Mode\n");
+        outPrintf("17. Set Operations\n");
+        outPrintf("18. Trade Pokemon\n");
+        outPrintf("19. Owner vs Owner Battle\n");
+        outPrintf("20. Team Optimizer\n");
+        outPrintf("21. Pokedex Summary\n");
 
         choice = readIntSafe("Your choice: ");
 
+        TraceSpan action = traceSpanBegin("Main menu action", choice);
         switch (choice) {
         case 1:
             openPokedexMenu();
@@ -1118,16 +5923,87 @@ void mainMenu() {
             printOwnersCircular();
             break;
         case 7:
-            printf("Goodbye!\n");
+            outPrintf("Goodbye!\n");
+            break;
+        case 8:
+            mergeManyPokedexesMenu();
+            break;
+        case 9:
+            whoHasPokemonMenu();
+            break;
+        case 10:
+            globalLeaderboardMenu();
+            break;
+        case 11:
+            scanSpeciesMenu();
+            break;
+        case 12:
+            cloneOwnerMenu();
+            break;
+        case 13:
+            undoLastChange();
+            break;
+        case 14:
+            redoLastChange();
+            break;
+        case 15:
+            autocompleteMenu();
+            break;
+        case 16:
+            toggleDirectoryModeMenu();
+            break;
+        case 17:
+            setOperationMenu();
+            break;
+        case 18:
+            tradePokemonMenu();
+            break;
+        case 19:
+            ownerBattleMenu();
+            break;
+        case 20:
+            teamOptimizerMenu();
+            break;
+        case 21:
+            pokedexSummaryMenu();
             break;
         default:
-            printf("Invalid choice.\n");
+            outPrintf("Invalid choice.\n");
         }
+        traceSpanEnd(&action);
     } while (choice != 7);
+    freeUndoLog();
     freeAllOwners();
+    freeOwnerDirectory();
+    freeSpeciesIndex();
+    freeSpeciesColumns();
+    freeSpeciesNameHash();
+    freeNameTrie(&speciesNameTrie);
+    freeNameTrie(&ownerNameTrie);
+    destroyTaskPool();
+    freeNodePool();
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    // usage: ex6 [catalog]  or  ex6 --write-catalog out.bin [catalog]
+    int writeCatalog = argc > 2 && strcmp(argv[1], "--write-catalog") == 0;
+    const char *catalogPath = writeCatalog ? (argc > 3 ? argv[3] : NULL) : (argc > 1 ? argv[1] : NULL);
+    if (catalogPath && !loadSpeciesCatalog(catalogPath) && writeCatalog)
+        return 1;
+
+    if (writeCatalog) {
+        int ok = writeSpeciesCatalog(argv[2]);
+        outPrintf(ok ? "Wrote %d species to %s.\n" : "Failed to write %d species to %s.\n",
+               speciesCount, argv[2]);
+        freeSpeciesCatalog();
+        return ok ? 0 : 1;
+    }
+
+    traceStart();
+    outStart();
     mainMenu(); // Call the main menu function
+    outStop();
+    traceDump();
+    freeSpeciesCatalog();
     return 0;   // Return 0 to indicate successful execution
 }
\ No newline at end of file
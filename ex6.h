@@ -1,10 +1,15 @@
 #ifndef EX6_H
 #define EX6_H
 
+// Needed for pthread rwlocks when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 
 typedef enum
@@ -26,6 +31,9 @@ typedef enum
     ICE
 } PokemonType;
 
+// Number of PokemonType values (GRASS..ICE)
+#define POKEMON_TYPE_COUNT 15
+
 typedef enum
 {
     CANNOT_EVOLVE,
@@ -42,26 +50,113 @@ typedef struct PokemonData
     EvolutionStatus CAN_EVOLVE;
 } PokemonData;
 
-// Binary Tree Node (for Pokédex)
+// Binary Tree Node (for Pokédex), 16 bytes, carved out of the node pool.
+// Children are 32-bit pool indices and the species is its catalog ID. The
+// 16-byte subtree summary sits in a parallel array of the same chunk, so every
+// Pokedex entry costs 32 bytes of pool, but a descent by ID only reads the
+// 16-byte nodes on its path.
+// Nodes may be shared between Pokedexes (copy-on-write); shared nodes are never
+// modified, a writer copies the path down to the node it changes.
 typedef struct PokemonNode
 {
-    PokemonData *data;
-    struct PokemonNode *left;
-    struct PokemonNode *right;
+    unsigned int left;        // Pool index of the left child, 0 if none
+    unsigned int right;       // Pool index of the right child, 0 if none
+    unsigned int refCount;    // Parents / owner roots pointing at this node
+    unsigned short speciesId; // Species ID (1-based) in the loaded catalog
 } PokemonNode;
 
+// Subtree summary of a node, 16 bytes, stored beside it in its pool chunk
+// (so node + summary = 32 bytes per entry)
+typedef struct
+{
+    int size;                 // Number of nodes in this subtree
+    int maxScore;             // Highest fight score in this subtree, in tenths
+    unsigned short maxHp;     // Highest HP in this subtree
+    unsigned short maxAttack; // Highest attack in this subtree
+    unsigned short typeMask;  // (1 << TYPE) of every Pokemon in this subtree
+    unsigned char evolveMask; // (1 << CAN_EVOLVE) of every Pokemon in this subtree
+} PokemonSummary;
+
+// Nodes per pool chunk; pool index = chunk number * NODE_POOL_CHUNK_SIZE + slot
+#define NODE_POOL_CHUNK_SIZE 1024
+// Chunk table size, so at most 64M nodes
+#define NODE_POOL_MAX_CHUNKS 65536
+// Largest species ID a node can hold
+#define POKEMON_NODE_MAX_SPECIES 65535
+
+// Chunks are aligned to their (power of two) size, so a node pointer finds its
+// chunk, and so its summary, by masking. Slot 0 is never handed out: its left
+// field holds the chunk number, and pool index 0 means "no child".
+typedef struct NodePoolChunk
+{
+    PokemonNode nodes[NODE_POOL_CHUNK_SIZE];
+    PokemonSummary summaries[NODE_POOL_CHUNK_SIZE];
+} NodePoolChunk;
+
+// One pool for every owner: clones and undo snapshots share subtrees across
+// owners, so a child index has to mean the same node in every tree.
+NodePoolChunk *nodePoolChunks[NODE_POOL_MAX_CHUNKS];
+int nodePoolChunkCount = 0;
+int nodePoolChunkUsed = NODE_POOL_CHUNK_SIZE; // slots carved from the newest chunk
+unsigned int nodePoolFree = 0;                 // freed nodes, linked through left
+pthread_mutex_t nodePoolLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Read-only snapshot of a Pokedex: IDs and inlined data in Eytzinger order
+// (index 1 is the root, k's children are 2k and 2k+1), in one allocation
+typedef struct
+{
+    int count;
+    int *ids;              // ids[1..count]; ids[0] unused
+    PokemonData *entries;  // entries[k] is the Pokemon with ids[k]
+} FrozenPokedex;
+
+// Owner names shorter than this are stored inside the OwnerNode
+#define OWNER_INLINE_NAME_SIZE 24
+
+// Running totals over a set of Pokemon, kept up to date as it changes
+typedef struct
+{
+    int count;
+    long long hpSum;
+    long long attackSum;
+    int typeCounts[POKEMON_TYPE_COUNT];
+} PokedexAggregates;
+
 // Linked List Node (for Owners)
 typedef struct OwnerNode
 {
-    char *ownerName;          // Owner's name
+    const char *ownerName;    // Owner's name: inlineName or an interned string
+    int nameLength;           // strlen(ownerName)
+    unsigned int nameHash;    // hashOwnerName(ownerName)
+    char inlineName[OWNER_INLINE_NAME_SIZE];
     PokemonNode *pokedexRoot; // Pointer to the root of the owner's Pokédex
+    FrozenPokedex *frozen;    // Lookup snapshot of pokedexRoot, NULL when thawed
+    struct PokemonColumns *columns; // Stat columns of pokedexRoot, built on first scan
     struct OwnerNode *next;   // Next owner in the linked list
     struct OwnerNode *prev;   // Previous owner in the linked list
+    pthread_rwlock_t lock;    // Shared for displays/fights, exclusive for mutations
+    int isRetired;            // Set while unlinked from the ring (undo may relink it)
+    int ownerSlot;            // Bit position in the species index, -1 while unlinked
+    PokedexAggregates totals; // Count/stat sums/type histogram while linked (speciesIndexLock)
+    unsigned long retireEpoch;     // Ring epoch at which the owner was unlinked
+    struct OwnerNode *retireNext;  // Next owner waiting to be reclaimed
+    int pinCount;                  // Menus using the owner outside a ring read section
 } OwnerNode;
 
 // Global head pointer for the linked list of owners
 OwnerNode *ownerHead = NULL;
 
+// Number of epoch slots used to reclaim unlinked owners
+#define RING_EPOCH_SLOTS 3
+
+// Serializes writers of the ring (link, unlink, sort); readers never take it
+pthread_mutex_t ownerRingLock = PTHREAD_MUTEX_INITIALIZER;
+// Current ring epoch and number of readers active in each epoch slot
+unsigned long ringEpoch = 0;
+int ringReaders[RING_EPOCH_SLOTS] = {0, 0, 0};
+// Owners unlinked from the ring that readers may still be looking at
+OwnerNode *retiredOwners = NULL;
+
 /* ------------------------------------------------------------
    1) Safe Input + Utility
    ------------------------------------------------------------ */
@@ -109,36 +204,104 @@ const char *getTypeName(PokemonType type);
    ------------------------------------------------------------ */
 
 /**
- * @brief Create a BST node with a copy of the given PokemonData.
- * @param data pointer to PokemonData (like from the global pokedex)
+ * @brief Create a BST node referring to the species entry for data->id.
+ * @param data pointer to PokemonData (like from the species catalog)
  * @return newly allocated PokemonNode*
- * Why we made it: We need a standard way to allocate BST nodes.
+ * Why we made it: We need a standard way to allocate BST nodes. Species data
+ * never changes, so nodes share it instead of copying data and name.
  */
 PokemonNode *createPokemonNode(const PokemonData *data);
 
+/**
+ * @brief Take a node from the pool / give one back.
+ * Why we made it: One contiguous chunk per 1024 nodes instead of a malloc each.
+ */
+PokemonNode *allocPokemonNode(void);
+void releasePokemonNode(PokemonNode *node);
+
+/**
+ * @brief Turn a pool index into a node pointer / a node pointer into its index.
+ * @return NULL for index 0 / 0 for NULL
+ * Why we made it: Child links are 32-bit indices, half the size of pointers.
+ */
+PokemonNode *nodeAtPoolIndex(unsigned int index);
+unsigned int poolIndexOfNode(const PokemonNode *node);
+
+/**
+ * @brief Read / set a child link.
+ * @param node a node (not NULL)
+ * @param child new child, may be NULL
+ * Why we made it: Every tree walk goes through these instead of the raw indices.
+ */
+PokemonNode *pokemonLeft(const PokemonNode *node);
+PokemonNode *pokemonRight(const PokemonNode *node);
+void setPokemonLeft(PokemonNode *node, PokemonNode *child);
+void setPokemonRight(PokemonNode *node, PokemonNode *child);
+
+/**
+ * @brief Species of a node, as its ID / as its catalog entry.
+ * @param node a node (not NULL)
+ * Why we made it: Nodes store only the 16-bit ID; comparisons by ID never
+ * touch the catalog.
+ */
+int pokemonID(const PokemonNode *node);
+const PokemonData *pokemonData(const PokemonNode *node);
+
+/**
+ * @brief The subtree summary kept beside a node.
+ * @param node a node (not NULL)
+ * Why we made it: Summaries are only read by pruned searches and rewritten on
+ * the way back up, so they stay out of the node; they still cost another 16
+ * bytes per entry.
+ */
+PokemonSummary *pokemonSummary(const PokemonNode *node);
+
+/**
+ * @brief Free every pool chunk at exit.
+ * Why we made it: Clean shutdown.
+ */
+void freeNodePool(void);
+
 /**
  * @brief Create an OwnerNode for the circular owners list.
- * @param ownerName the dynamically allocated name
+ * @param ownerName the name (copied; the caller keeps its buffer)
  * @param starter BST root for the starter Pokemon
  * @return newly allocated OwnerNode*
  * Why we made it: Each user is represented as an OwnerNode.
  */
-OwnerNode *createOwner(char *ownerName, PokemonNode *starter);
+OwnerNode *createOwner(const char *ownerName, PokemonNode *starter);
 
 /**
- * @brief Free one PokemonNode (including name).
+ * @brief Free one PokemonNode (its species data is shared and stays).
  * @param node pointer to node
  * Why we made it: Avoid memory leaks for single nodes.
  */
 void freePokemonNode(PokemonNode *node);
 
 /**
- * @brief Recursively free a BST of PokemonNodes.
+ * @brief Drop one reference to a BST; nodes nobody else shares are freed.
  * @param root BST root
  * Why we made it: Clearing a user’s entire Pokedex means freeing a tree.
  */
 void freePokemonTree(PokemonNode *root);
 
+/**
+ * @brief Take another reference to a whole BST.
+ * @param root BST root (may be NULL)
+ * @return root
+ * Why we made it: Cloning a Pokedex shares the tree instead of copying it.
+ */
+PokemonNode *sharePokemonTree(PokemonNode *root);
+
+/**
+ * @brief Make a node safe to modify, copying it if it is shared.
+ * @param node node reached from an already-owned parent (or the owner root)
+ * @return node itself, or a private copy that replaces the caller's reference
+ * Why we made it: Insert and remove call it on their way down, so a mutation
+ * copies at most the O(h) nodes on its path (h = tree height).
+ */
+PokemonNode *ownPokemonNode(PokemonNode *node);
+
 /**
  * @brief Free an OwnerNode (including name and entire Pokedex BST).
  * @param owner pointer to the owner
@@ -155,10 +318,19 @@ void freeOwnerNode(OwnerNode *owner);
  * @param root pointer to BST root
  * @param newNode node to insert
  * @return updated BST root
- * Why we made it: Standard BST insertion ignoring duplicates.
+ * Why we made it: Standard BST insertion ignoring duplicates. The ID is looked
+ * up first, so a duplicate leaves shared (copy-on-write) nodes uncopied.
  */
 PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode);
 
+/**
+ * @brief Recompute a node's subtree summary from its own data and its children.
+ * @param node the node (children must already be up to date)
+ * Why we made it: Queries skip whole subtrees using these summaries, so every
+ * insert/remove refreshes them on the way back up.
+ */
+void updatePokemonSummary(PokemonNode *node);
+
 /**
  * @brief BFS search for a Pokemon by ID in the BST.
  * @param root BST root
@@ -182,7 +354,8 @@ PokemonNode *removeNodeBST(PokemonNode *root, int id);
  * @param root BST root
  * @param id the ID to remove
  * @return updated BST root
- * Why we made it: BFS confirms existence, then removeNodeBST does the removal.
+ * Why we made it: A descent confirms existence first, so a miss leaves shared
+ * (copy-on-write) nodes uncopied; only the path to a real removal is copied.
  */
 PokemonNode *removePokemonByID(PokemonNode *root, int id);
 
@@ -227,6 +400,74 @@ void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
  */
 void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
 
+typedef enum
+{
+    ORDER_BFS,
+    ORDER_PRE,
+    ORDER_IN,
+    ORDER_POST
+} TraversalOrder;
+
+// Pull-style traversal state: a stack (DFS orders) or ring queue (BFS),
+// never the whole tree.
+typedef struct
+{
+    TraversalOrder order;
+    PokemonNode **items;
+    int head;     // first queued node (BFS only)
+    int size;
+    int capacity;
+    PokemonNode *pending;     // subtree still to descend into (in/post-order)
+    PokemonNode *lastVisited; // last node returned (post-order)
+} PokemonCursor;
+
+// Visitor with a context pointer; return 0 to stop the traversal early.
+typedef int (*VisitNodeCtxFunc)(PokemonNode *, void *);
+
+/**
+ * @brief Start a cursor over a BST in the given order.
+ * @param cursor cursor to initialize
+ * @param root BST root (may be NULL)
+ * @param order BFS, pre-, in- or post-order
+ * Why we made it: Lets callers pull nodes one at a time and stop whenever they like.
+ */
+void cursorInit(PokemonCursor *cursor, PokemonNode *root, TraversalOrder order);
+
+/**
+ * @brief Return the next node of the traversal.
+ * @param cursor an initialized cursor
+ * @return next node, or NULL when the traversal is done
+ * Why we made it: Streaming/paging through big Pokedexes without a NodeArray.
+ */
+PokemonNode *cursorNext(PokemonCursor *cursor);
+
+/**
+ * @brief Release the cursor's stack/queue.
+ * @param cursor cursor to free
+ * Why we made it: Cursors may be abandoned halfway through a traversal.
+ */
+void cursorFree(PokemonCursor *cursor);
+
+/**
+ * @brief Visit nodes in the given order, passing ctx, until visit returns 0.
+ * @param root BST root
+ * @param order traversal order
+ * @param visit visitor taking (node, ctx)
+ * @param ctx caller data handed to every call
+ * @return 1 if the visitor stopped the traversal, 0 if it ran to the end
+ * Why we made it: VisitNodeFunc carries no context and can't stop early.
+ */
+int traverseWithContext(PokemonNode *root, TraversalOrder order, VisitNodeCtxFunc visit, void *ctx);
+
+/**
+ * @brief Start an in-order cursor whose first node is the one at position k.
+ * @param cursor cursor to initialize
+ * @param root BST root
+ * @param k 0-based position in ID order
+ * Why we made it: Paging seeks in O(h) using subtree sizes, then streams.
+ */
+void cursorInitAtRank(PokemonCursor *cursor, PokemonNode *root, int k);
+
 /**
  * @brief Print one PokemonNode’s data: ID, Name, Type, HP, Attack, Evolve?
  * @param node pointer to the node
@@ -270,7 +511,7 @@ void addNode(NodeArray *na, PokemonNode *node);
 void collectAll(PokemonNode *root, NodeArray *na);
 
 /**
- * @brief Compare function for qsort (alphabetical by node->data->name).
+ * @brief Compare function for qsort (alphabetical by species name).
  * @param a pointer to a pointer to PokemonNode
  * @param b pointer to a pointer to PokemonNode
  * @return -1, 0, or +1
@@ -345,6 +586,107 @@ void addPokemon(OwnerNode *owner);
  */
 void freePokemon(OwnerNode *owner);
 
+/**
+ * @brief Number of Pokemon in a subtree (0 for NULL).
+ * @param node subtree root
+ * @return the size
+ * Why we made it: Order statistics read subtree sizes everywhere.
+ */
+int pokemonTreeSize(const PokemonNode *node);
+
+/**
+ * @brief Return the k-th Pokemon in ID order.
+ * @param root BST root
+ * @param k 1-based position
+ * @return the node, or NULL if k is out of range
+ * Why we made it: "The 500th entry by ID" in O(h) (h = tree height; the tree is not
+ * balanced, so h can reach n when IDs arrive in order).
+ */
+PokemonNode *selectPokemonByRank(PokemonNode *root, int k);
+
+/**
+ * @brief Count how many Pokemon have an ID smaller than id.
+ * @param root BST root
+ * @param id the ID
+ * @return number of smaller IDs (so id's 1-based position, if present, is this + 1)
+ * Why we made it: Rank in O(h) using subtree sizes (h = tree height).
+ */
+int rankOfPokemonID(PokemonNode *root, int id);
+
+/**
+ * @brief Print one page of the Pokedex in ID order.
+ * @param root BST root
+ * @param offset 0-based index of the first entry
+ * @param limit max entries to print
+ * @return number of entries printed
+ * Why we made it: Paged display costs O(h + limit), not a full walk.
+ */
+int displayPokedexPage(PokemonNode *root, int offset, int limit);
+
+/**
+ * @brief Prompt for page size and number, then print that page of an owner.
+ * @param owner pointer to the Owner
+ * Why we made it: The paged option of displayMenu.
+ */
+void displayPagedMenu(OwnerNode *owner);
+
+/**
+ * @brief Show the Pokemon at a position, or the position of an ID.
+ * @param owner the owner whose Pokedex is queried
+ * @param byPosition 1 = position -> Pokemon, 0 = ID -> position
+ * Why we made it: The rank/select options of displayMenu.
+ */
+void displayRankMenu(OwnerNode *owner, int byPosition);
+
+/**
+ * @brief Filters for queryPokedex; a Pokemon must pass all of them.
+ */
+typedef struct
+{
+    int minID;              // inclusive
+    int maxID;              // inclusive
+    unsigned int typeMask;  // allowed types as (1 << TYPE); 0 means any type
+    int minHp;
+    int minAttack;
+    int evolve;             // -1 for any, otherwise CAN_EVOLVE / CANNOT_EVOLVE
+} PokemonQuery;
+
+/**
+ * @brief Emit matching Pokemon in ID order, pruning subtrees that can't match.
+ * @param root BST root
+ * @param query the filters
+ * @param emit called for each match with ctx; return 0 to stop
+ * @param ctx caller data
+ * @return 1 if emit stopped the query early, otherwise 0
+ * Why we made it: ID ranges prune the descent, and the per-node type mask and
+ * max HP/attack skip subtrees that have no possible match.
+ */
+int queryPokedex(PokemonNode *root, const PokemonQuery *query, VisitNodeCtxFunc emit, void *ctx);
+
+/**
+ * @brief Check one Pokemon against every filter of a query.
+ * @param data the Pokemon
+ * @param query the filters
+ * @return 1 if it passes
+ * Why we made it: Shared by the tree query and the column scans.
+ */
+int pokemonMatchesQuery(const PokemonData *data, const PokemonQuery *query);
+
+/**
+ * @brief Prompt for the query filters (ID range, type, HP, attack, evolve).
+ * @param query filled in on success
+ * @return 1 if all answers were valid, 0 otherwise
+ * Why we made it: Pokedex queries and catalog scans ask the same questions.
+ */
+int readPokemonQuery(PokemonQuery *query);
+
+/**
+ * @brief Prompt for query filters and print every matching Pokemon.
+ * @param owner pointer to the Owner
+ * Why we made it: Lets users filter a Pokedex instead of dumping all of it.
+ */
+void queryPokedexMenu(OwnerNode *owner);
+
 /* ------------------------------------------------------------
    7) Display Menu for a Pokedex
    ------------------------------------------------------------ */
@@ -367,12 +709,15 @@ void displayMenu(OwnerNode *owner);
 void sortOwners(void);
 
 /**
- * @brief Helper to swap name & pokedexRoot in two OwnerNode.
- * @param a pointer to first owner
- * @param b pointer to second owner
- * Why we made it: Used internally by bubble sort to swap data.
+ * @brief Order owners alphabetically by name, ties by address.
+ * @param a first owner
+ * @param b second owner
+ * @return negative, 0, or positive like strcmp
+ * Why we made it: The owner directory's order; sortOwners relinks whole nodes
+ * along it instead of swapping their data, so a reader holding an OwnerNode
+ * never sees it turn into another owner.
  */
-void swapOwnerData(OwnerNode *a, OwnerNode *b);
+int compareDirectoryOwners(const OwnerNode *a, const OwnerNode *b);
 
 /* ------------------------------------------------------------
    9) Circular List Linking & Searching
@@ -385,6 +730,16 @@ void swapOwnerData(OwnerNode *a, OwnerNode *b);
  */
 void linkOwnerInCircularList(OwnerNode *newOwner);
 
+/**
+ * @brief Link a clone, copying its source's species index instead of walking
+ *        the shared tree.
+ * @param clone new owner whose root is a shared reference to source's root
+ * @param source the owner it was cloned from
+ * Why we made it: Keeps cloning independent of the Pokedex size; falls back to
+ * indexing the tree if source changed or left the ring meanwhile.
+ */
+void linkClonedOwnerInCircularList(OwnerNode *clone, OwnerNode *source);
+
 /**
  * @brief Remove a specific OwnerNode from the circular list, possibly updating head.
  * @param target pointer to the OwnerNode
@@ -438,6 +793,16 @@ void mergePokedexMenu(void);
  */
 void printOwnersCircular(void);
 
+/**
+ * @brief Write times lines of "[i] name" walking the ring from head.
+ * @param head where the walk starts
+ * @param direction 'f' forward, 'b' backward, anything else stays on head
+ * @param times number of lines
+ * Why we made it: Walks the ring once and reuses the names by position,
+ * so a million prints cost one ring walk and a few large writes.
+ */
+void writeOwnerRing(OwnerNode *head, char direction, int times);
+
 /* ------------------------------------------------------------
    12) Cleanup All Owners at Program End
    ------------------------------------------------------------ */
@@ -447,153 +812,1470 @@ void printOwnersCircular(void);
  * Why we made it: Ensures a squeaky-clean exit with no leftover memory.
  */
 void freeAllOwners(void);
-void mergePokedexes(PokemonNode *firstRoot, PokemonNode *secondRoot);
+
+/**
+ * @brief Copy every Pokemon of the second owner into the first owner's Pokedex.
+ * @param first owner receiving the Pokemon (caller holds its write lock)
+ * @param second owner being copied from (caller holds its read lock)
+ * Why we made it: Takes owners rather than roots so an empty first Pokedex
+ * gets a real root and the species index sees the new entries.
+ */
+void mergePokedexes(OwnerNode *first, OwnerNode *second);
+
 /* ------------------------------------------------------------
-   13) The Main Menu
+   13) Concurrency: Owner Locks & Ring Reclamation
    ------------------------------------------------------------ */
 
 /**
- * @brief The main driver loop for the program (new pokedex, merge, fight, etc.).
- * Why we made it: Our top-level UI that keeps the user engaged until they exit.
+ * @brief Enter a ring read section; owners seen inside it stay allocated.
+ * @return the epoch to hand back to ringReadEnd
+ * Why we made it: Ring traversals must not block inserts or deletes, so readers
+ * only announce themselves and writers defer freeing unlinked owners.
  */
-void mainMenu(void);
+unsigned long ringReadBegin(void);
 
-// Array of Pokemon data
-static const PokemonData pokedex[] = {
-    {1, "Bulbasaur", GRASS, 45, 49, CAN_EVOLVE},
-    {2, "Ivysaur", GRASS, 60, 62, CAN_EVOLVE},
-    {3, "Venusaur", GRASS, 80, 82, CANNOT_EVOLVE},
-    {4, "Charmander", FIRE, 39, 52, CAN_EVOLVE},
-    {5, "Charmeleon", FIRE, 58, 64, CAN_EVOLVE},
-    {6, "Charizard", FIRE, 78, 84, CANNOT_EVOLVE},
-    {7, "Squirtle", WATER, 44, 48, CAN_EVOLVE},
-    {8, "Wartortle", WATER, 59, 63, CAN_EVOLVE},
-    {9, "Blastoise", WATER, 79, 83, CANNOT_EVOLVE},
-    {10, "Caterpie", BUG, 45, 30, CAN_EVOLVE},
-    {11, "Metapod", BUG, 50, 20, CAN_EVOLVE},
-    {12, "Butterfree", BUG, 60, 45, CANNOT_EVOLVE},
-    {13, "Weedle", BUG, 40, 35, CAN_EVOLVE},
-    {14, "Kakuna", BUG, 45, 25, CAN_EVOLVE},
-    {15, "Beedrill", BUG, 65, 90, CANNOT_EVOLVE},
-    {16, "Pidgey", NORMAL, 40, 45, CAN_EVOLVE},
-    {17, "Pidgeotto", NORMAL, 63, 60, CAN_EVOLVE},
-    {18, "Pidgeot", NORMAL, 83, 80, CANNOT_EVOLVE},
-    {19, "Rattata", NORMAL, 30, 56, CAN_EVOLVE},
-    {20, "Raticate", NORMAL, 55, 81, CANNOT_EVOLVE},
-    {21, "Spearow", NORMAL, 40, 60, CAN_EVOLVE},
-    {22, "Fearow", NORMAL, 65, 90, CANNOT_EVOLVE},
-    {23, "Ekans", POISON, 35, 60, CAN_EVOLVE},
-    {24, "Arbok", POISON, 60, 85, CANNOT_EVOLVE},
-    {25, "Pikachu", ELECTRIC, 35, 55, CAN_EVOLVE},
-    {26, "Raichu", ELECTRIC, 60, 90, CANNOT_EVOLVE},
-    {27, "Sandshrew", GROUND, 50, 75, CAN_EVOLVE},
-    {28, "Sandslash", GROUND, 75, 100, CANNOT_EVOLVE},
-    {29, "NidoranF", POISON, 55, 47, CAN_EVOLVE},
-    {30, "Nidorina", POISON, 70, 62, CAN_EVOLVE},
-    {31, "Nidoqueen", POISON, 90, 92, CANNOT_EVOLVE},
-    {32, "NidoranM", POISON, 46, 57, CAN_EVOLVE},
-    {33, "Nidorino", POISON, 61, 72, CAN_EVOLVE},
-    {34, "Nidoking", POISON, 81, 102, CANNOT_EVOLVE},
-    {35, "Clefairy", FAIRY, 70, 45, CAN_EVOLVE},
-    {36, "Clefable", FAIRY, 95, 70, CANNOT_EVOLVE},
-    {37, "Vulpix", FIRE, 38, 41, CAN_EVOLVE},
-    {38, "Ninetales", FIRE, 73, 76, CANNOT_EVOLVE},
-    {39, "Jigglypuff", NORMAL, 115, 45, CAN_EVOLVE},
-    {40, "Wigglytuff", NORMAL, 140, 70, CANNOT_EVOLVE},
-    {41, "Zubat", POISON, 40, 45, CAN_EVOLVE},
-    {42, "Golbat", POISON, 75, 80, CAN_EVOLVE},
-    {43, "Oddish", GRASS, 45, 50, CAN_EVOLVE},
-    {44, "Gloom", GRASS, 60, 65, CAN_EVOLVE},
-    {45, "Vileplume", GRASS, 75, 80, CANNOT_EVOLVE},
-    {46, "Paras", BUG, 35, 70, CAN_EVOLVE},
-    {47, "Parasect", BUG, 60, 95, CANNOT_EVOLVE},
-    {48, "Venonat", BUG, 60, 55, CAN_EVOLVE},
-    {49, "Venomoth", BUG, 70, 65, CANNOT_EVOLVE},
-    {50, "Diglett", GROUND, 10, 55, CAN_EVOLVE},
-    {51, "Dugtrio", GROUND, 35, 80, CANNOT_EVOLVE},
-    {52, "Meowth", NORMAL, 40, 45, CAN_EVOLVE},
-    {53, "Persian", NORMAL, 65, 70, CANNOT_EVOLVE},
-    {54, "Psyduck", WATER, 50, 52, CAN_EVOLVE},
-    {55, "Golduck", WATER, 80, 82, CANNOT_EVOLVE},
-    {56, "Mankey", FIGHTING, 40, 80, CAN_EVOLVE},
-    {57, "Primeape", FIGHTING, 65, 105, CANNOT_EVOLVE},
-    {58, "Growlithe", FIRE, 55, 70, CAN_EVOLVE},
-    {59, "Arcanine", FIRE, 90, 110, CANNOT_EVOLVE},
-    {60, "Poliwag", WATER, 40, 50, CAN_EVOLVE},
-    {61, "Poliwhirl", WATER, 65, 65, CAN_EVOLVE},
-    {62, "Poliwrath", WATER, 90, 95, CANNOT_EVOLVE},
-    {63, "Abra", PSYCHIC, 25, 20, CAN_EVOLVE},
-    {64, "Kadabra", PSYCHIC, 40, 35, CAN_EVOLVE},
-    {65, "Alakazam", PSYCHIC, 55, 50, CANNOT_EVOLVE},
-    {66, "Machop", FIGHTING, 70, 80, CAN_EVOLVE},
-    {67, "Machoke", FIGHTING, 80, 100, CAN_EVOLVE},
-    {68, "Machamp", FIGHTING, 90, 130, CANNOT_EVOLVE},
-    {69, "Bellsprout", GRASS, 50, 75, CAN_EVOLVE},
-    {70, "Weepinbell", GRASS, 65, 90, CAN_EVOLVE},
-    {71, "Victreebel", GRASS, 80, 105, CANNOT_EVOLVE},
-    {72, "Tentacool", WATER, 40, 40, CAN_EVOLVE},
-    {73, "Tentacruel", WATER, 80, 70, CANNOT_EVOLVE},
-    {74, "Geodude", ROCK, 40, 80, CAN_EVOLVE},
-    {75, "Graveler", ROCK, 55, 95, CAN_EVOLVE},
-    {76, "Golem", ROCK, 80, 120, CANNOT_EVOLVE},
-    {77, "Ponyta", FIRE, 50, 85, CAN_EVOLVE},
-    {78, "Rapidash", FIRE, 65, 100, CANNOT_EVOLVE},
-    {79, "Slowpoke", WATER, 90, 65, CAN_EVOLVE},
-    {80, "Slowbro", WATER, 95, 75, CANNOT_EVOLVE},
-    {81, "Magnemite", ELECTRIC, 25, 35, CAN_EVOLVE},
-    {82, "Magneton", ELECTRIC, 50, 60, CANNOT_EVOLVE},
-    {83, "Farfetch'd", NORMAL, 52, 65, CANNOT_EVOLVE},
-    {84, "Doduo", NORMAL, 35, 85, CAN_EVOLVE},
-    {85, "Dodrio", NORMAL, 60, 110, CANNOT_EVOLVE},
-    {86, "Seel", WATER, 65, 45, CAN_EVOLVE},
-    {87, "Dewgong", WATER, 90, 70, CANNOT_EVOLVE},
-    {88, "Grimer", POISON, 80, 80, CAN_EVOLVE},
-    {89, "Muk", POISON, 105, 105, CANNOT_EVOLVE},
-    {90, "Shellder", WATER, 30, 65, CAN_EVOLVE},
-    {91, "Cloyster", WATER, 50, 95, CANNOT_EVOLVE},
-    {92, "Gastly", GHOST, 30, 35, CAN_EVOLVE},
-    {93, "Haunter", GHOST, 45, 50, CAN_EVOLVE},
-    {94, "Gengar", GHOST, 60, 65, CANNOT_EVOLVE},
-    {95, "Onix", ROCK, 35, 45, CANNOT_EVOLVE},
-    {96, "Drowzee", PSYCHIC, 60, 48, CAN_EVOLVE},
-    {97, "Hypno", PSYCHIC, 85, 73, CANNOT_EVOLVE},
-    {98, "Krabby", WATER, 30, 105, CAN_EVOLVE},
-    {99, "Kingler", WATER, 55, 130, CANNOT_EVOLVE},
-    {100, "Voltorb", ELECTRIC, 40, 30, CAN_EVOLVE},
-    {101, "Electrode", ELECTRIC, 60, 50, CANNOT_EVOLVE},
-    {102, "Exeggcute", GRASS, 60, 40, CAN_EVOLVE},
-    {103, "Exeggutor", GRASS, 95, 95, CANNOT_EVOLVE},
-    {104, "Cubone", GROUND, 50, 50, CAN_EVOLVE},
-    {105, "Marowak", GROUND, 60, 80, CANNOT_EVOLVE},
-    {106, "Hitmonlee", FIGHTING, 50, 120, CANNOT_EVOLVE},
-    {107, "Hitmonchan", FIGHTING, 50, 105, CANNOT_EVOLVE},
-    {108, "Lickitung", NORMAL, 90, 55, CANNOT_EVOLVE},
-    {109, "Koffing", POISON, 40, 65, CAN_EVOLVE},
-    {110, "Weezing", POISON, 65, 90, CANNOT_EVOLVE},
-    {111, "Rhyhorn", GROUND, 80, 85, CAN_EVOLVE},
-    {112, "Rhydon", GROUND, 105, 130, CANNOT_EVOLVE},
-    {113, "Chansey", NORMAL, 250, 5, CANNOT_EVOLVE},
-    {114, "Tangela", GRASS, 65, 55, CANNOT_EVOLVE},
-    {115, "Kangaskhan", NORMAL, 105, 95, CANNOT_EVOLVE},
-    {116, "Horsea", WATER, 30, 40, CAN_EVOLVE},
-    {117, "Seadra", WATER, 55, 65, CANNOT_EVOLVE},
-    {118, "Goldeen", WATER, 45, 67, CAN_EVOLVE},
-    {119, "Seaking", WATER, 80, 92, CANNOT_EVOLVE},
-    {120, "Staryu", WATER, 30, 45, CAN_EVOLVE},
-    {121, "Starmie", WATER, 60, 75, CANNOT_EVOLVE},
-    {122, "Mr. Mime", PSYCHIC, 40, 45, CANNOT_EVOLVE},
-    {123, "Scyther", BUG, 70, 110, CANNOT_EVOLVE},
-    {124, "Jynx", ICE, 65, 50, CANNOT_EVOLVE},
-    {125, "Electabuzz", ELECTRIC, 65, 83, CANNOT_EVOLVE},
-    {126, "Magmar", FIRE, 65, 95, CANNOT_EVOLVE},
-    {127, "Pinsir", BUG, 65, 125, CANNOT_EVOLVE},
-    {128, "Tauros", NORMAL, 75, 100, CANNOT_EVOLVE},
-    {129, "Magikarp", WATER, 20, 10, CAN_EVOLVE},
-    {130, "Gyarados", WATER, 95, 125, CANNOT_EVOLVE},
-    {131, "Lapras", WATER, 130, 85, CANNOT_EVOLVE},
-    {132, "Ditto", NORMAL, 48, 48, CANNOT_EVOLVE},
-    {133, "Eevee", NORMAL, 55, 55, CAN_EVOLVE},
-    {134, "Vaporeon", WATER, 130, 65, CANNOT_EVOLVE},
+/**
+ * @brief Leave a ring read section started by ringReadBegin.
+ * @param epoch value returned by ringReadBegin
+ * Why we made it: Lets writers reclaim owners once no reader can still see them.
+ */
+void ringReadEnd(unsigned long epoch);
+
+/**
+ * @brief Load the next/previous owner or the ring head with acquire semantics.
+ * Why we made it: Readers walk the ring while a writer may be relinking it.
+ */
+OwnerNode *ownerNext(OwnerNode *owner);
+OwnerNode *ownerPrev(OwnerNode *owner);
+OwnerNode *getOwnerHead(void);
+
+/**
+ * @brief Count the owners linked in the ring. Call inside a ring read section.
+ * @return number of linked owners, 0 for an empty ring
+ * Why we made it: Bounds how many distinct owners a menu may ask for.
+ */
+int countLinkedOwners(void);
+
+/**
+ * @brief Keep an owner allocated after leaving the ring read section it was
+ *        found in / release it again.
+ * @param owner the owner (pinOwner: caller is inside a ring read section;
+ *        unpinOwner accepts NULL)
+ * Why we made it: Menus that wait for user input in between must not hold a
+ * read section open, which would stop every retired owner being reclaimed.
+ */
+void pinOwner(OwnerNode *owner);
+void unpinOwner(OwnerNode *owner);
+
+/**
+ * @brief The owner at a 1-based position from the head, as menus number them.
+ *        Call inside a ring read section.
+ * @param position 1 for the head
+ * @return the owner, or NULL past the end of the ring
+ * Why we made it: Menus list the ring, leave the read section for the prompt
+ * and find the chosen owner again afterwards.
+ */
+OwnerNode *ownerAtPosition(int position);
+
+/**
+ * @brief Look an owner up by name and pin it.
+ * @param name the owner's name
+ * @return the pinned owner, or NULL when no owner has that name
+ * Why we made it: The lookup half of most menus; release with unpinOwner.
+ */
+OwnerNode *findAndPinOwner(const char *name);
+
+/**
+ * @brief Queue an unlinked owner for freeing once all older readers are gone.
+ * @param owner owner already unlinked from the ring (caller holds ownerRingLock)
+ * Why we made it: Epoch-based reclamation for OwnerNodes.
+ */
+void retireOwner(OwnerNode *owner);
+
+/**
+ * @brief Advance the ring epoch if possible and free owners no reader can see.
+ * Pinned owners stay on the retired list until they are unpinned.
+ * Why we made it: Called by writers (holding ownerRingLock) after retiring owners.
+ */
+void reclaimRetiredOwners(void);
+
+/**
+ * @brief Take an owner's Pokedex lock shared (reads) or exclusive (mutations).
+ * @param owner pointer to the owner
+ * Why we made it: Mutations lock only the affected owner; readers share access.
+ */
+void lockOwnerRead(OwnerNode *owner);
+void lockOwnerWrite(OwnerNode *owner);
+void unlockOwner(OwnerNode *owner);
+
+/**
+ * @brief Lock two owners (write the first, read the second) in a fixed order.
+ * @param dest owner being modified
+ * @param src owner only being read (may equal dest)
+ * Why we made it: Merging touches two Pokedexes; a global order avoids deadlock.
+ */
+void lockOwnerPair(OwnerNode *dest, OwnerNode *src);
+void unlockOwnerPair(OwnerNode *dest, OwnerNode *src);
+
+/* ------------------------------------------------------------
+   14) Work-Stealing Task Pool & Merge Many
+   ------------------------------------------------------------ */
+
+// Upper bound on pool workers regardless of how many cores we see
+#define MAX_POOL_WORKERS 16
+// Subtrees smaller than this are built by a single task
+#define PARALLEL_BUILD_CUTOFF 512
+
+typedef void (*TaskFunc)(void *);
+
+typedef struct
+{
+    TaskFunc func;
+    void *arg;
+} Task;
+
+// One worker's deque: the owner pushes/pops at the tail, thieves take the head
+typedef struct
+{
+    Task *tasks;
+    int head;
+    int size;
+    int capacity;
+    pthread_mutex_t lock;
+} TaskDeque;
+
+typedef struct
+{
+    pthread_t *threads;
+    TaskDeque *deques;
+    int workerCount;
+    int queued;      // tasks sitting in some deque
+    int pending;     // tasks submitted but not yet finished
+    int nextDeque;   // round-robin target for submissions from outside the pool
+    int stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t workReady;
+    pthread_cond_t allDone;
+} TaskPool;
+
+// Lazily created pool shared by every parallel operation
+TaskPool *taskPool = NULL;
+
+/**
+ * @brief Return the shared pool, starting one worker per core on first use.
+ * @return pointer to the pool
+ * Why we made it: Parallel merges should not pay for thread startup each time.
+ */
+TaskPool *getTaskPool(void);
+
+/**
+ * @brief Queue a task; workers submit to their own deque, others round-robin.
+ * @param pool the pool
+ * @param func function to run
+ * @param arg its argument
+ * Why we made it: Tasks may spawn subtasks, which idle workers steal.
+ */
+void submitTask(TaskPool *pool, TaskFunc func, void *arg);
+
+/**
+ * @brief Block until every submitted task (and their subtasks) has finished.
+ * @param pool the pool
+ * Why we made it: Each merge phase must finish before the next one starts.
+ */
+void waitTaskPool(TaskPool *pool);
+
+/**
+ * @brief Stop and join the workers, then free the pool.
+ * Why we made it: Clean exit with no threads or memory left behind.
+ */
+void destroyTaskPool(void);
+
+/**
+ * @brief Recursively collect all nodes from the BST in ascending ID order.
+ * @param root BST root
+ * @param na pointer to NodeArray
+ * Why we made it: A sorted run per owner is the input of the k-way merge.
+ */
+void collectInOrder(PokemonNode *root, NodeArray *na);
+
+/**
+ * @brief Merge sorted runs into one sorted, duplicate-free NodeArray in parallel.
+ * @param runs array of sorted runs
+ * @param runCount number of runs
+ * @param merged output array (initialized by the caller)
+ * Why we made it: The ID space is split into ranges merged independently.
+ */
+void parallelMergeRuns(NodeArray *runs, int runCount, NodeArray *merged);
+
+/**
+ * @brief Build a balanced BST copying the sorted nodes, big subtrees in parallel.
+ * @param sorted nodes in ascending ID order
+ * @return root of the new tree
+ * Why we made it: The merged Pokedex is rebuilt in one pass instead of n inserts.
+ */
+PokemonNode *parallelBuildTree(NodeArray *sorted);
+
+/**
+ * @brief Unlink several owners from the ring under a single lock and retire them.
+ * @param owners the owners to remove
+ * @param count how many
+ * Why we made it: Retiring hundreds of merged owners one by one is wasteful.
+ */
+void removeOwnersFromCircularList(OwnerNode **owners, int count);
+
+/**
+ * @brief Merge any number of owners into one destination, then remove them.
+ * Why we made it: Consolidating many owners with the two-owner merge is slow.
+ */
+void mergeManyPokedexesMenu(void);
+
+/* ------------------------------------------------------------
+   15) Species -> Owners Index
+   ------------------------------------------------------------ */
+
+#define BITS_PER_WORD (8 * (int)sizeof(unsigned long))
+
+// One bitset of owner slots per species; bit s is set when ownerSlots[s] holds it
+unsigned long **speciesOwnerBits = NULL;
+int speciesOwnerWords = 0;    // words per bitset
+OwnerNode **ownerSlots = NULL; // slot -> owner, NULL for free slots
+int ownerSlotCount = 0;       // slots handed out so far
+// Sum of the totals of every linked owner
+PokedexAggregates ringTotals;
+// Guards everything above (and each owner's totals); mutations write, lookups read
+pthread_rwlock_t speciesIndexLock = PTHREAD_RWLOCK_INITIALIZER;
+
+/**
+ * @brief Give a newly linked owner a slot and index every species it holds.
+ * @param owner the owner
+ * Why we made it: Called from linkOwnerInCircularList so the index always
+ * mirrors the ring.
+ */
+void indexOwnerLinked(OwnerNode *owner);
+
+/**
+ * @brief Give a clone a slot holding a copy of its source's bits and totals.
+ * @param owner the clone (caller holds ownerRingLock)
+ * @param source the owner it shares its root with
+ * Why we made it: A clone holds exactly its source's species, so one pass
+ * over the source's column replaces the tree walk of indexOwnerLinked.
+ */
+void indexOwnerCloned(OwnerNode *owner, OwnerNode *source);
+
+/**
+ * @brief Drop an owner from every posting set and free its slot.
+ * @param owner the owner (caller holds ownerRingLock)
+ * Why we made it: Called when an owner is unlinked (delete, merge).
+ */
+void indexOwnerUnlinked(OwnerNode *owner);
+
+/**
+ * @brief Record that an owner gained or lost one species.
+ * @param owner the owner
+ * @param id species ID
+ * Why we made it: Keeps the index exact after add/release/evolve/merge.
+ * The owner's bit tells whether it really changed, so the owner and ring
+ * totals only move when it did (merges report IDs the owner already had).
+ * Real changes are staged for the undo log.
+ */
+void indexPokemonAdded(OwnerNode *owner, int id);
+void indexPokemonRemoved(OwnerNode *owner, int id);
+
+/**
+ * @brief Find the owners holding every one of the given species.
+ * @param ids species IDs
+ * @param idCount how many IDs
+ * @param out set to a malloc'd array of owners (caller frees), NULL if none
+ * @return number of owners found
+ * Why we made it: Answers "who has X (and Y)?" by ANDing bitsets, no tree walks.
+ */
+int findSpeciesOwners(const int *ids, int idCount, OwnerNode ***out);
+
+/**
+ * @brief Prompt for one or more Pokemon IDs and list the owners holding all of them.
+ * Why we made it: User-facing "who has Pikachu?" lookup.
+ */
+void whoHasPokemonMenu(void);
+
+/* ------------------------------------------------------------
+   16) Leaderboards (Top-K by Fight Score)
+   ------------------------------------------------------------ */
+
+// One leaderboard row
+typedef struct
+{
+    const PokemonData *data;
+    OwnerNode *owner;
+    int scoreTenths;
+} LeaderboardEntry;
+
+// Species IDs sorted by fight score (best first), built on first use
+int *speciesByScore = NULL;
+
+/**
+ * @brief Fight score (attack * 1.5 + hp * 1.2) in tenths, as an exact integer.
+ * @param data the Pokemon
+ * @return the score times 10
+ * Why we made it: Integer scores compare exactly in the tree summaries.
+ */
+int pokemonScoreTenths(const PokemonData *data);
+
+/**
+ * @brief Collect an owner's k strongest Pokemon, best first.
+ * @param root owner's BST root
+ * @param k how many to return
+ * @param out room for k entries
+ * @return number of entries written
+ * Why we made it: Best-first search on the per-subtree max score opens only
+ * O(k) nodes, however big the Pokedex is.
+ */
+int topPokemonOfOwner(PokemonNode *root, int k, LeaderboardEntry *out);
+
+/**
+ * @brief Collect the k strongest (owner, Pokemon) pairs across all owners.
+ * @param k how many to return
+ * @param out room for k entries
+ * @return number of entries written
+ * Why we made it: Walks species by score and reads who owns each from the
+ * species index, so no tree is touched.
+ */
+int topPokemonGlobal(int k, LeaderboardEntry *out);
+
+/**
+ * @brief Prompt for K and print an owner's leaderboard.
+ * @param owner pointer to the Owner
+ * Why we made it: "Who's my strongest Pokemon?" without dumping everything.
+ */
+void ownerLeaderboardMenu(OwnerNode *owner);
+
+/**
+ * @brief Prompt for K and print the global leaderboard.
+ * Why we made it: Same question across every owner.
+ */
+void globalLeaderboardMenu(void);
+
+/* ------------------------------------------------------------
+   17) Frozen (Eytzinger) Pokedex Layout
+   ------------------------------------------------------------ */
+
+// How many Eytzinger levels ahead the frozen search prefetches
+#define FROZEN_PREFETCH_LEVELS 4
+
+/**
+ * @brief Build a contiguous Eytzinger-ordered snapshot of an owner's tree.
+ * @param owner the owner (caller holds its write lock)
+ * @return 1 on success, 0 if the Pokedex is empty or allocation failed
+ * Why we made it: Lookups in the snapshot touch one cache-friendly array
+ * instead of chasing node -> data -> name pointers.
+ */
+int freezePokedex(OwnerNode *owner);
+
+/**
+ * @brief Drop an owner's frozen snapshot; the tree is the source of truth again.
+ * @param owner the owner (caller holds its write lock)
+ * Why we made it: Every mutation calls this before touching the tree, so the
+ * first change after a freeze transparently thaws it.
+ */
+void thawPokedex(OwnerNode *owner);
+
+/**
+ * @brief Branch-free, prefetching lower-bound search in a frozen snapshot.
+ * @param frozen the snapshot
+ * @param id ID to find
+ * @return the Pokemon's data, or NULL
+ * Why we made it: The hot lookup path for read-mostly Pokedexes.
+ */
+const PokemonData *searchFrozenPokedex(const FrozenPokedex *frozen, int id);
+
+/**
+ * @brief Look up a Pokemon an owner holds, via the snapshot when frozen.
+ * @param owner the owner (caller holds its lock)
+ * @param id ID to find
+ * @return the Pokemon's data, or NULL
+ * Why we made it: One lookup for readers whether or not the owner is frozen.
+ */
+const PokemonData *findOwnedPokemon(OwnerNode *owner, int id);
+
+/**
+ * @brief Freeze the owner's Pokedex from the sub-menu.
+ * @param owner pointer to the Owner
+ * Why we made it: Lets users mark a Pokedex as read-mostly.
+ */
+void freezePokedexMenu(OwnerNode *owner);
+
+/* ------------------------------------------------------------
+   18) Struct-of-Arrays Stat Columns & SIMD Scans
+   ------------------------------------------------------------ */
+
+// GCC vector extension: 4 ints per operation, SSE2/NEON when available
+typedef int IntVector __attribute__((vector_size(4 * sizeof(int))));
+#define SIMD_LANES 4
+
+// Parallel arrays of the scan-relevant fields, in one allocation
+typedef struct PokemonColumns
+{
+    int count;
+    int *ids;
+    int *hp;
+    int *attack;
+    unsigned char *types;
+    unsigned char *canEvolve;
+} PokemonColumns;
+
+// Result of scanColumns
+typedef struct
+{
+    int count;
+    long hpSum;
+    long attackSum;
+    int bestIndex;         // row of the strongest match, -1 if none
+    int bestScoreTenths;
+    int typeCounts[POKEMON_TYPE_COUNT];
+} ColumnStats;
+
+// Columns of the whole species table, built once
+PokemonColumns *speciesColumns = NULL;
+pthread_once_t speciesColumnsOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Allocate columns for count rows / free them.
+ * Why we made it: All columns live in a single block.
+ */
+PokemonColumns *allocPokemonColumns(int count);
+void freePokemonColumns(PokemonColumns *cols);
+
+/**
+ * @brief Columns of the species table (built on first use).
+ * @return the columns, or NULL if allocation failed
+ * Why we made it: Catalog-wide scans read only the fields they need.
+ */
+const PokemonColumns *getSpeciesColumns(void);
+
+/**
+ * @brief Columns of an owner's Pokedex in ID order, cached until the next mutation.
+ * @param owner the owner (caller holds its read lock)
+ * @return the columns, or NULL if allocation failed
+ * Why we made it: Per-owner scans stream arrays instead of walking the tree.
+ */
+const PokemonColumns *getOwnerColumns(OwnerNode *owner);
+
+/**
+ * @brief Fight score (in tenths) of every row, four rows per vector op.
+ * @param cols the columns
+ * @param scoreTenths output, one per row
+ * Why we made it: Scores the whole catalog in one pass when the global
+ * leaderboard order (speciesByScore) is first built.
+ */
+void scoreColumns(const PokemonColumns *cols, int *scoreTenths);
+
+/**
+ * @brief Filter rows by a query and aggregate the matches in one vectorized pass.
+ * @param cols the columns
+ * @param query the filters
+ * @param stats count, HP/attack sums, strongest row and type histogram
+ * Why we made it: Filtering and aggregation kernel over the columns.
+ */
+void scanColumns(const PokemonColumns *cols, const PokemonQuery *query, ColumnStats *stats);
+
+/**
+ * @brief Print count/averages/strongest/type histogram of an owner's Pokedex.
+ * @param owner pointer to the Owner
+ * Why we made it: Summary view backed by the column scan.
+ */
+void ownerStatsMenu(OwnerNode *owner);
+
+/**
+ * @brief Prompt for filters and aggregate the matching species of the catalog.
+ * Why we made it: Catalog-wide stat scans.
+ */
+void scanSpeciesMenu(void);
+
+/* ------------------------------------------------------------
+   19) Cloning Pokedexes
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Create a new owner whose Pokedex is a copy-on-write clone of another.
+ * Why we made it: The clone shares the whole tree in O(1); both sides copy
+ * only the nodes they change afterwards.
+ */
+void cloneOwnerMenu(void);
+
+/* ------------------------------------------------------------
+   20) Undo & Redo
+   ------------------------------------------------------------ */
+
+// Number of changes kept for undo
+#define UNDO_LOG_CAPACITY 32
+
+// One owner root before and after a change; both hold a tree reference
+typedef struct
+{
+    OwnerNode *owner;
+    PokemonNode *before;
+    PokemonNode *after;
+    int *indexChanges;    // species the change indexed, in order: +id added, -id removed
+    int indexChangeCount;
+} UndoRootChange;
+
+// A species index change of the current menu action, until a root change
+// claims it: +id added to / -id removed from owner
+typedef struct
+{
+    OwnerNode *owner;
+    int change;
+} UndoIndexChange;
+
+// An owner a change linked into or unlinked from the ring
+typedef struct
+{
+    OwnerNode *owner;
+    OwnerNode *prev;  // ring neighbour at the last unlink, to relink in place
+    int wasHead;      // owner was ownerHead at the last unlink
+} UndoOwnerChange;
+
+// Pokemon two owners swapped. Undo moves them back instead of keeping old
+// roots, so a trade never shares (and later copies) the live trees.
+typedef struct
+{
+    OwnerNode *first;
+    OwnerNode *second;
+    int *ids;         // what first gave, then what second gave
+    int firstCount;
+    int secondCount;
+} UndoTradeChange;
+
+// Everything one menu action changed
+typedef struct
+{
+    const char *label;
+    UndoRootChange *roots;
+    int rootCount;
+    UndoTradeChange *trades;
+    int tradeCount;
+    UndoOwnerChange *linked;   // owners the action added
+    int linkedCount;
+    UndoOwnerChange *unlinked; // owners the action removed (kept alive, not retired)
+    int unlinkedCount;
+} UndoRecord;
+
+// Circular log: slots [0, undoTop) can be undone, [undoTop, undoEnd) redone,
+// counted from undoBase
+UndoRecord undoLog[UNDO_LOG_CAPACITY];
+int undoBase = 0;
+int undoTop = 0;
+int undoEnd = 0;
+// Guards the log; taken before ownerRingLock and the owner locks
+pthread_mutex_t undoLock = PTHREAD_MUTEX_INITIALIZER;
+// Change being built by the current menu action (menu thread only)
+UndoRecord undoPending = {NULL, NULL, 0, NULL, 0, NULL, 0, NULL, 0};
+// Index changes made since the last commit (speciesIndexLock)
+UndoIndexChange *undoStagedIndex = NULL;
+int undoStagedIndexCount = 0;
+
+/**
+ * @brief Note that an owner's root changed.
+ * @param owner the owner (caller holds its write lock, after the change and
+ *        its indexPokemonAdded/Removed calls)
+ * @param before reference to the old root, taken with sharePokemonTree
+ * Why we made it: Copy-on-write keeps the old version intact, so undo only
+ * needs the two root pointers; the versions share all untouched nodes. The
+ * owner's staged index changes move into the record, so undo/redo replays
+ * them instead of diffing the two trees.
+ */
+void undoRecordRoot(OwnerNode *owner, PokemonNode *before);
+
+/**
+ * @brief Stage one species index change of the current menu action.
+ * @param owner the owner whose index changed (caller holds speciesIndexLock
+ *        for writing)
+ * @param change +id when the species was added, -id when removed
+ * Why we made it: The index hooks already know exactly what changed; keeping
+ * it costs O(1) per change, and undoCommit drops what no root change claimed.
+ */
+void undoStageIndexChange(OwnerNode *owner, int change);
+
+/**
+ * @brief Note a trade between two owners.
+ * @param first, second the owners (caller holds both write locks)
+ * @param firstIds, firstCount what first gave (copied)
+ * @param secondIds, secondCount what second gave (copied)
+ * Why we made it: The inverse of a trade is the same move with the offers
+ * swapped, so the log keeps two ID lists instead of two tree snapshots.
+ */
+void undoRecordTrade(OwnerNode *first, const int *firstIds, int firstCount, OwnerNode *second,
+                     const int *secondIds, int secondCount);
+
+/**
+ * @brief Note that an owner was linked into / unlinked from the ring.
+ * @param owner the owner
+ * @param prev its ring neighbour at the unlink
+ * @param wasHead whether it was ownerHead at the unlink
+ * Why we made it: Unlinked owners stay alive while a change can bring them back.
+ */
+void undoRecordLinked(OwnerNode *owner);
+void undoRecordUnlinked(OwnerNode *owner, OwnerNode *prev, int wasHead);
+
+/**
+ * @brief Push the pending change onto the log under the given label.
+ * @param label what the menu action did, shown by undo/redo
+ * Why we made it: One menu action is one undo step; a new change drops the
+ * redo branch and, when the log is full, the oldest change.
+ */
+void undoCommit(const char *label);
+
+/**
+ * @brief Revert / reapply the newest change.
+ * Why we made it: Each step swaps root pointers and replays their recorded
+ * index changes, moves traded Pokemon back or forth and relinks owners, so it
+ * costs what the change did, not the size of the trees.
+ */
+void undoLastChange(void);
+void redoLastChange(void);
+
+/**
+ * @brief Drop every logged change at exit.
+ * Why we made it: Owners only the log kept alive go to the retired list.
+ */
+void freeUndoLog(void);
+
+/**
+ * @brief Unlink an owner without retiring it / link it back after prev.
+ * @param owner the owner (caller holds ownerRingLock)
+ * @param prev neighbour to relink after; the tail when it is no longer linked
+ * @param makeHead whether the owner becomes ownerHead again (both ignored in
+ *        directory mode, which links at the sorted position)
+ * Why we made it: Shared by delete, merge and undo/redo; the species index
+ * follows the ring.
+ */
+void unlinkOwnerLocked(OwnerNode *owner);
+void relinkOwnerLocked(OwnerNode *owner, OwnerNode *prev, int makeHead);
+
+/* ------------------------------------------------------------
+   21) Species Catalog
+   ------------------------------------------------------------ */
+
+// Binary catalog file: header, count records, then nameBytes of NUL-terminated
+// names. Integers are 32-bit in host byte order.
+#define CATALOG_MAGIC "PKDXCAT1"
+#define CATALOG_MAGIC_LENGTH 8
+
+typedef struct
+{
+    char magic[CATALOG_MAGIC_LENGTH];
+    int count;
+    int nameBytes;
+} CatalogFileHeader;
+
+typedef struct
+{
+    int id;
+    int type;
+    int hp;
+    int attack;
+    int canEvolve;
+    int nameOffset; // into the name block
+} CatalogFileRecord;
+
+/**
+ * @brief Look up a species in the active catalog.
+ * @param id species ID
+ * @return the species, or NULL when the ID is outside the catalog
+ * Why we made it: Every ID typed by the user goes through here instead of
+ * indexing the table directly.
+ */
+const PokemonData *getSpeciesByID(int id);
+
+/**
+ * @brief Replace the built-in catalog with one loaded from a file.
+ * @param path binary catalog (mmapped, names used in place) or CSV with lines
+ *        "id,name,TYPE,hp,attack,canEvolve"; needs the 7 starter IDs and at
+ *        most POKEMON_NODE_MAX_SPECIES entries
+ * @return 1 on success, 0 (built-in catalog kept) on any error
+ * Why we made it: Bigger catalogs without recompiling. A binary file skips text
+ * parsing, but its records are still validated and copied into PokemonData
+ * entries in one O(n) pass at startup.
+ */
+int loadSpeciesCatalog(const char *path);
+
+/**
+ * @brief Write the active catalog as a binary catalog file.
+ * @param path output file
+ * @return 1 on success, 0 on error
+ * Why we made it: Turns a CSV catalog (or the built-in one) into the fast format.
+ */
+int writeSpeciesCatalog(const char *path);
+
+/**
+ * @brief Unmap / free a loaded catalog.
+ * Why we made it: Clean shutdown.
+ */
+void freeSpeciesCatalog(void);
+
+/* ------------------------------------------------------------
+   22) Species Name Lookup
+   ------------------------------------------------------------ */
+
+// Average names per bucket of the perfect hash
+#define SPECIES_NAME_BUCKET_LOAD 4
+// Seeds tried per bucket before giving up on the perfect hash
+#define SPECIES_NAME_MAX_SEED (1 << 20)
+
+// Minimal perfect hash over the catalog names (hash and displace): a name's
+// bucket picks a seed, and the seed picks its slot among speciesCount slots.
+int *speciesNameSeeds = NULL;                 // seed per bucket
+int speciesNameBucketCount = 0;
+int *speciesNameSlots = NULL;                 // slot -> species ID, 0 if empty
+unsigned long long *speciesNameHashes = NULL; // slot -> hash of that name
+pthread_once_t speciesNameOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Hash a species name with case folded in.
+ * @param name the name
+ * @return 64-bit hash, equal for names that differ only in case
+ * Why we made it: Folding inside the hash loop makes case-insensitive lookup free.
+ */
+unsigned long long hashSpeciesName(const char *name);
+
+/**
+ * @brief Resolve a species name (any case) to its ID.
+ * @param name the name
+ * @return the species ID, or 0 when no species has that name
+ * Why we made it: One hash, one slot and one comparison instead of a strcmp
+ * over the whole catalog.
+ */
+int findSpeciesIDByName(const char *name);
+
+/**
+ * @brief Read a species ID, or a species name resolved to its ID.
+ * @param prompt text printed before each attempt
+ * @return the ID (not range-checked for numbers)
+ * Why we made it: add/release/fight/evolve accept names as well as IDs.
+ */
+int readPokemonIDSafe(const char *prompt);
+
+/**
+ * @brief Free the name hash at exit.
+ * Why we made it: Clean shutdown.
+ */
+void freeSpeciesNameHash(void);
+
+/* ------------------------------------------------------------
+   23) Name Autocomplete
+   ------------------------------------------------------------ */
+
+// Suggestions printed per list by the autocomplete menu
+#define AUTOCOMPLETE_MAX_MATCHES 10
+// Largest typo count the autocomplete menu accepts
+#define AUTOCOMPLETE_MAX_TYPOS 3
+
+// A name stored in a trie; several names can fold to the same key
+typedef struct NameTrieValue
+{
+    const char *name;        // original spelling (not owned)
+    const void *item;        // PokemonData* or OwnerNode*
+    struct NameTrieValue *next;
+} NameTrieValue;
+
+// Radix trie over lowercased names: every edge carries a label, and every node
+// other than the root either ends a name or has two or more children
+typedef struct NameTrieNode
+{
+    char *label;
+    int labelLength;
+    struct NameTrieNode *child;   // first child, children sorted by label[0]
+    struct NameTrieNode *sibling; // next child of the same parent
+    NameTrieValue *values;        // names ending here
+} NameTrieNode;
+
+typedef struct
+{
+    const char *name;
+    const void *item;
+    int distance; // edits between the query and the closest prefix of name
+} NameMatch;
+
+// Species names (built from the catalog on first use) and linked owner names
+NameTrieNode speciesNameTrie = {NULL, 0, NULL, NULL, NULL};
+NameTrieNode ownerNameTrie = {NULL, 0, NULL, NULL, NULL};
+pthread_once_t speciesNameTrieOnce = PTHREAD_ONCE_INIT;
+// Guards ownerNameTrie; taken after ownerRingLock
+pthread_rwlock_t ownerNameTrieLock = PTHREAD_RWLOCK_INITIALIZER;
+
+/**
+ * @brief Add / remove a name in a trie.
+ * @param root trie root
+ * @param name the name (kept by pointer, must outlive the entry)
+ * @param item what the name stands for
+ * Why we made it: Owners enter and leave the trie as they are linked and
+ * unlinked; removal re-merges nodes so the trie stays a radix trie.
+ */
+void nameTrieInsert(NameTrieNode *root, const char *name, const void *item);
+void nameTrieRemove(NameTrieNode *root, const char *name, const void *item);
+
+/**
+ * @brief Names starting with a prefix, in alphabetical order.
+ * @param root trie root
+ * @param prefix case-insensitive prefix
+ * @param max size of out
+ * @param out filled with the matches
+ * @return number of matches
+ * Why we made it: Walks the prefix, then only the matching subtree; radix
+ * nodes branch or end a name, so the walk costs O(prefix + output).
+ */
+int nameTrieComplete(const NameTrieNode *root, const char *prefix, int max, NameMatch *out);
+
+/**
+ * @brief Names with a prefix within maxEdits edits of the query, closest first.
+ * @param root trie root
+ * @param query what was typed (case-insensitive)
+ * @param maxEdits largest edit distance allowed
+ * @param max size of out
+ * @param out filled with the matches
+ * @return number of matches
+ * Why we made it: Typo-tolerant suggestions; one edit-distance row per trie
+ * character, and branches are cut once every entry of the row is too large.
+ */
+int nameTrieFuzzy(const NameTrieNode *root, const char *query, int maxEdits, int max, NameMatch *out);
+
+/**
+ * @brief Free a trie's nodes.
+ * Why we made it: Clean shutdown.
+ */
+void freeNameTrie(NameTrieNode *root);
+
+/**
+ * @brief Keep ownerNameTrie in step with the ring.
+ * @param owner the owner (caller holds ownerRingLock)
+ * Why we made it: Called wherever owners are linked or unlinked, like the
+ * species index.
+ */
+void nameTrieOwnerLinked(OwnerNode *owner);
+void nameTrieOwnerUnlinked(OwnerNode *owner);
+
+/**
+ * @brief Prompt for a prefix and suggest species and owner names.
+ * Why we made it: Lets users find names without knowing IDs or exact spelling.
+ */
+void autocompleteMenu(void);
+
+/* ------------------------------------------------------------
+   24) Sorted Owner Directory
+   ------------------------------------------------------------ */
+
+#define OWNER_DIRECTORY_MAX_LEVEL 16
+
+// Skip list node; forward[i] is the next node on level i
+typedef struct OwnerDirectoryNode
+{
+    OwnerNode *owner;
+    int level;
+    struct OwnerDirectoryNode *forward[];
+} OwnerDirectoryNode;
+
+// Skip list of every linked owner ordered by name (ties by address). The ring
+// is a view over it: in directory mode each owner is linked at its sorted
+// position, so the ring always reads in name order starting at ownerHead.
+OwnerDirectoryNode *ownerDirectory = NULL; // sentinel, allocated on first insert
+int ownerDirectoryLevel = 1;               // levels in use
+int ownerDirectoryMode = 0;                // keep the ring sorted on insert
+unsigned int ownerDirectorySeed = 2463534242u;
+// Guards the skip list; taken after ownerRingLock
+pthread_rwlock_t ownerDirectoryLock = PTHREAD_RWLOCK_INITIALIZER;
+
+/**
+ * @brief Add / remove an owner in the directory.
+ * @param owner the owner (caller holds ownerRingLock)
+ * Why we made it: Called wherever owners are linked or unlinked; O(log n).
+ */
+void directoryInsertOwner(OwnerNode *owner);
+void directoryRemoveOwner(OwnerNode *owner);
+
+/**
+ * @brief The owner sorting right before the given one in the directory.
+ * @param owner an owner already in the directory
+ * @return the predecessor, or NULL if owner is first
+ * Why we made it: In directory mode new owners are linked right after it.
+ */
+OwnerNode *directoryPredecessor(OwnerNode *owner);
+
+/**
+ * @brief Link an owner into the ring at the right place for the current mode.
+ * @param owner the owner, already in the directory (caller holds ownerRingLock)
+ * @param prev ring neighbour to follow outside directory mode (NULL = tail)
+ * @param makeHead outside directory mode, whether it becomes ownerHead
+ * Why we made it: One place decides between "append/restore" and "sorted".
+ */
+void linkOwnerInRingLocked(OwnerNode *owner, OwnerNode *prev, int makeHead);
+
+/**
+ * @brief Turn directory mode on (sorting the ring once) or off.
+ * Why we made it: The sorted ring is optional; plain mode keeps insertion order.
+ */
+void toggleDirectoryModeMenu(void);
+
+/**
+ * @brief Free the skip list at exit.
+ * Why we made it: Clean shutdown.
+ */
+void freeOwnerDirectory(void);
+
+/* ------------------------------------------------------------
+   25) Owner Name Storage
+   ------------------------------------------------------------ */
+
+// Buffer for reading an owner name (longest allowed name plus terminator)
+#define OWNER_NAME_BUFFER_SIZE (MAX_OWNER_NAME_LENGTH + 1)
+// Buckets of the interned-name table
+#define INTERN_TABLE_SIZE 256
+
+// A long owner name shared by every owner spelled the same way
+typedef struct InternedName
+{
+    struct InternedName *next;
+    unsigned int hash;
+    int length;
+    int refCount;
+    char text[];
+} InternedName;
+
+InternedName *internTable[INTERN_TABLE_SIZE];
+pthread_mutex_t internLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Hash an owner name.
+ * @param name the name
+ * @param length its length
+ * @return 32-bit FNV-1a hash
+ * Why we made it: Cached in the OwnerNode so equality checks reject most
+ * candidates without touching the strings.
+ */
+unsigned int hashOwnerName(const char *name, int length);
+
+/**
+ * @brief Store a name in an owner: inline when short, interned when long.
+ * @param owner the owner
+ * @param name the name (copied)
+ * Why we made it: Most names fit inside the node, so creating an owner does
+ * not allocate a separate name.
+ */
+void setOwnerName(OwnerNode *owner, const char *name);
+
+/**
+ * @brief Release an owner's name (drops the interned reference, if any).
+ * @param owner the owner
+ * Why we made it: Pairs with setOwnerName in freeOwnerNode.
+ */
+void clearOwnerName(OwnerNode *owner);
+
+/**
+ * @brief Check an owner's name against a string with known length and hash.
+ * @return 1 when equal
+ * Why we made it: Length and hash compare first; the bytes only on a hit.
+ */
+int ownerNameEquals(const OwnerNode *owner, const char *name, int length, unsigned int hash);
+
+/**
+ * @brief Read one line as an owner name into a caller buffer.
+ * @param buffer at least OWNER_NAME_BUFFER_SIZE bytes
+ * @return 1 if the trimmed name fits, 0 if it is too long (line consumed)
+ * Why we made it: Lookups by name (merge, merge many, clone) read into the
+ * stack instead of allocating a temporary copy.
+ */
+int readOwnerName(char *buffer);
+
+/* ------------------------------------------------------------
+   26) Trace Spans
+   ------------------------------------------------------------ */
+
+// Environment variable naming the Chrome trace file to write at exit
+#define TRACE_ENV_VAR "EX6_TRACE"
+// Spans kept per thread; older ones are overwritten when it fills
+#define TRACE_BUFFER_CAPACITY 16384
+// Open spans tracked per thread (deeper nesting is not recorded)
+#define TRACE_MAX_DEPTH 64
+
+// One finished span
+typedef struct
+{
+    const char *name;
+    unsigned long long startNs;
+    unsigned long long durationNs;
+    int arg;                  // menu choice, or -1
+} TraceEvent;
+
+// Per-thread ring of finished spans
+typedef struct TraceBuffer
+{
+    struct TraceBuffer *next;
+    int threadId;
+    int workerIndex;          // -1 for the main thread
+    int depth;                // open spans on this thread
+    const char *open[TRACE_MAX_DEPTH];
+    long long recorded;       // spans ever recorded (ring index = recorded % capacity)
+    TraceEvent events[TRACE_BUFFER_CAPACITY];
+} TraceBuffer;
+
+// An open span; start is 0 when it is not being recorded
+typedef struct
+{
+    const char *name;
+    unsigned long long start;
+    int arg;
+} TraceSpan;
+
+int traceEnabled = 0;
+char *traceOutputPath = NULL;
+TraceBuffer *traceBuffers = NULL;
+int traceThreadCount = 0;
+pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Turn tracing on when TRACE_ENV_VAR names an output file.
+ * Why we made it: Tracing costs one branch per span when it is off.
+ */
+void traceStart(void);
+
+/**
+ * @brief Open a span on the calling thread.
+ * @param name a string that outlives the trace (a literal or __func__)
+ * @param arg menu choice to attach, or -1
+ * @return the span to hand to traceSpanEnd
+ * Why we made it: Recursive calls to the same function fold into the
+ * outermost span instead of flooding the buffer.
+ */
+TraceSpan traceSpanBegin(const char *name, int arg);
+
+/**
+ * @brief Close a span and record it in the thread's buffer.
+ * @param span the span from traceSpanBegin
+ * Why we made it: Also used as a cleanup handler by TRACE_SPAN.
+ */
+void traceSpanEnd(TraceSpan *span);
+
+/**
+ * @brief Write every recorded span as Chrome trace JSON and free the buffers.
+ * Why we made it: chrome://tracing and Perfetto open the file directly.
+ */
+void traceDump(void);
+
+// Trace the rest of the enclosing function (closes on every return path)
+#define TRACE_SPAN() \
+    TraceSpan traceSpan __attribute__((cleanup(traceSpanEnd))) = traceSpanBegin(__func__, -1)
+
+/* ------------------------------------------------------------
+   27) Set Operations Between Owners
+   ------------------------------------------------------------ */
+
+typedef enum
+{
+    SET_INTERSECTION = 1,     // species every owner has
+    SET_DIFFERENCE,           // species the first owner has and none of the others do
+    SET_SYMMETRIC_DIFFERENCE  // species an odd number of owners have
+} SetOperation;
+
+/**
+ * @brief Combine the Pokedexes of several owners with a set operation.
+ * @param owners the owners (caller holds their read locks)
+ * @param count how many owners
+ * @param op the operation
+ * @param result receives the matching nodes in ID order
+ * Why we made it: One linear merge over in-order cursors instead of a
+ * searchPokemonBFS per Pokemon per owner.
+ */
+void combineOwnerSets(OwnerNode **owners, int count, SetOperation op, NodeArray *result);
+
+/**
+ * @brief Prompt for an operation and owners, print the result and
+ * optionally save it as a new owner.
+ * Why we made it: Comparing collections without dumping and diffing by hand.
+ */
+void setOperationMenu(void);
+
+/* ------------------------------------------------------------
+   28) Trading Pokemon
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Unhook a node from a BST without freeing it.
+ * @param root the tree root
+ * @param id the ID to detach
+ * @param detached receives the node (children cleared), or stays NULL
+ * @return the new root
+ * Why we made it: A traded Pokemon moves to the other tree as the same
+ * node instead of being freed on one side and created on the other.
+ */
+PokemonNode *detachPokemonByID(PokemonNode *root, int id, PokemonNode **detached);
+
+/**
+ * @brief Detach both offers, then insert each into the other owner's tree.
+ * @param first, second the owners (caller holds both write locks)
+ * @param firstIds, firstCount what first gives (all present, already checked)
+ * @param secondIds, secondCount what second gives
+ * Why we made it: Shared by the trade menu and by undo/redo. Nodes move
+ * without allocation when the trees are private; a node still shared with a
+ * clone or an older undo snapshot is copied on write first, like any change.
+ */
+void moveTradedPokemon(OwnerNode *first, const int *firstIds, int firstCount, OwnerNode *second,
+                       const int *secondIds, int secondCount);
+
+/**
+ * @brief Prompt for two owners and the Pokemon each gives, then swap them.
+ * Why we made it: Every check runs before anything moves, so a trade
+ * either happens completely or not at all.
+ */
+void tradePokemonMenu(void);
+
+/* ------------------------------------------------------------
+   29) Asynchronous Output
+   ------------------------------------------------------------ */
+
+// Bytes of rendered output that may be waiting for the writer (power of two)
+#define OUTPUT_RING_SIZE 65536
+// Messages shorter than this are formatted on the stack
+#define OUTPUT_FORMAT_BUFFER_SIZE 512
+
+// Single-producer/single-consumer byte ring: the menu thread appends at
+// outputHead, the writer thread drains up to it and advances outputTail.
+char outputRing[OUTPUT_RING_SIZE];
+unsigned long outputHead = 0;
+unsigned long outputTail = 0;
+int outputStarted = 0;
+int outputStopping = 0;
+int outputWriterIdle = 0;        // writer is (about to be) asleep on outputReady
+int outputProducerWaiting = 0;   // threads (about to be) asleep on outputDrained
+pthread_t outputWriter;
+// only used to sleep and wake; the ring itself is lock-free
+pthread_mutex_t outputLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t outputReady = PTHREAD_COND_INITIALIZER;
+pthread_cond_t outputDrained = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @brief Start the writer thread; later output goes through the ring.
+ * Why we made it: A slow terminal or pipe only slows the writer, not the
+ * command that produced the text.
+ */
+void outStart(void);
+
+/**
+ * @brief Drain everything queued so far, then stop the writer thread.
+ * Why we made it: Nothing may be lost at exit.
+ */
+void outStop(void);
+
+/**
+ * @brief printf through the output ring.
+ * Why we made it: Every message of the program goes through here so the
+ * order on stdout stays the order of the calls.
+ */
+int outPrintf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Append raw bytes to the output ring, waiting while it is full.
+ * @param data the bytes
+ * @param length how many
+ * Why we made it: Bounded memory; a producer far ahead of the terminal
+ * waits instead of growing a queue.
+ */
+void outWrite(const char *data, size_t length);
+
+/**
+ * @brief Wait until the writer has put everything queued so far on stdout.
+ * Why we made it: Prompts must be visible before we block reading stdin.
+ */
+void outFlush(void);
+
+/* ------------------------------------------------------------
+   30) Battle Simulation
+   ------------------------------------------------------------ */
+
+// Battles per single matchup in the owner menu
+#define BATTLE_TRIALS 20000
+// Battles per matchup when two whole Pokedexes fight
+#define BATTLE_TRIALS_PER_MATCHUP 500
+// A battle still going after this many turns is a tie
+#define BATTLE_MAX_TURNS 100
+// Share of the attack stat dealt per hit before type and luck
+#define BATTLE_DAMAGE_SCALE 0.25
+// Hit chance, critical chance and critical multiplier
+#define BATTLE_HIT_CHANCE 0.95
+#define BATTLE_CRIT_CHANCE (1.0 / 16.0)
+#define BATTLE_CRIT_MULTIPLIER 1.5
+// Damage rolls land in [BATTLE_MIN_ROLL, 1]
+#define BATTLE_MIN_ROLL 0.85
+// Battles per pool task in the single matchup mode
+#define BATTLE_TRIALS_PER_TASK 2500
+
+// typeEffectiveness[attacker][defender]: 2 super effective, 0.5 not very, 0 immune
+double typeEffectiveness[POKEMON_TYPE_COUNT][POKEMON_TYPE_COUNT];
+pthread_once_t typeEffectivenessOnce = PTHREAD_ONCE_INIT;
+// Advanced once per simulation, so repeated runs differ but scripts are reproducible
+unsigned long long battleSeed = 0x9E3779B97F4A7C15ull;
+
+// Outcome counts of a batch of battles
+typedef struct
+{
+    long long firstWins;
+    long long secondWins;
+    long long ties;
+} BattleTally;
+
+/**
+ * @brief Fill typeEffectiveness (run once through typeEffectivenessOnce).
+ * Why we made it: One table lookup per hit instead of a switch on both types.
+ */
+void buildTypeEffectiveness(void);
+
+/**
+ * @brief Fight one randomized turn-based battle.
+ * @param first the first Pokemon
+ * @param second the second Pokemon
+ * @param rng the caller's generator state (advanced)
+ * @return 1 if first wins, 2 if second wins, 0 for a tie
+ * Why we made it: The building block every simulation repeats.
+ */
+int simulateBattle(const PokemonData *first, const PokemonData *second, unsigned long long *rng);
+
+/**
+ * @brief Run many battles of one matchup and count the outcomes.
+ * @param first the first Pokemon
+ * @param second the second Pokemon
+ * @param trials how many battles
+ * @param seed RNG seed for this batch
+ * @param tally receives the counts
+ * Why we made it: Each pool task owns its own generator, so there is no
+ * shared RNG state between threads and results don't depend on scheduling.
+ */
+void simulateMatchup(const PokemonData *first, const PokemonData *second, long long trials,
+                     unsigned long long seed, BattleTally *tally);
+
+/**
+ * @brief Owner menu: estimate win chances of two owned Pokemon.
+ * @param owner the owner
+ * Why we made it: pokemonFight's formula ignores types; this doesn't.
+ */
+void battleSimulationMenu(OwnerNode *owner);
+
+/**
+ * @brief Main menu: every Pokemon of one owner against every Pokemon of another.
+ * Why we made it: Thousands of matchups spread over the task pool.
+ */
+void ownerBattleMenu(void);
+
+/* ------------------------------------------------------------
+   31) Team Optimizer
+   ------------------------------------------------------------ */
+
+// Largest team the optimizer picks
+#define TEAM_SIZE 6
+// Simulated battles behind each pairwise win chance
+#define TEAM_TRIALS_PER_MATCHUP 200
+// Search nodes (across all threads) before settling for the best team so far
+#define TEAM_SEARCH_NODE_LIMIT 20000000LL
+// Scores closer than this count as equal when pruning
+#define TEAM_SCORE_EPSILON 1e-9
+
+// Shared state of one team search
+typedef struct
+{
+    const float *winChance;   // winChance[i * opponentCount + j]: candidate i beats opponent j
+    int candidateCount;
+    int opponentCount;
+    int teamSize;
+    double bestScore;         // read without the lock for pruning
+    int bestTeam[TEAM_SIZE];
+    long long nodes;          // search nodes visited (atomic)
+    int stoppedEarly;
+    pthread_mutex_t lock;     // guards bestScore/bestTeam updates
+} TeamSearch;
+
+/**
+ * @brief Find the team maximizing the summed best win chance against each opponent.
+ * @param search the search (winChance, counts and teamSize filled in)
+ * Why we made it: Greedy gives the starting bound, then branch-and-bound
+ * runs one pool task per first member, all pruning against the shared best.
+ */
+void searchBestTeam(TeamSearch *search);
+
+/**
+ * @brief Prompt for an owner and an opponent, then print the best team.
+ * Why we made it: Picking counters by hand took hundreds of fights.
+ */
+void teamOptimizerMenu(void);
+
+/* ------------------------------------------------------------
+   32) Pokedex Summaries
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Add (sign 1) or remove (sign -1) one species from a set of totals.
+ * @param totals the totals
+ * @param species the species
+ * @param sign 1 or -1
+ * Why we made it: The O(1) step behind every owner and ring total.
+ */
+void updateAggregates(PokedexAggregates *totals, const PokemonData *species, int sign);
+
+/**
+ * @brief Print count, HP/attack sums and averages and the type histogram.
+ * @param label who the totals belong to
+ * @param totals the totals
+ * Why we made it: Shared by the per-owner and ring-wide lines.
+ */
+void printAggregates(const char *label, const PokedexAggregates *totals);
+
+/**
+ * @brief Print every owner's totals and the ring-wide totals.
+ * Why we made it: Reads the maintained aggregates instead of walking trees.
+ */
+void pokedexSummaryMenu(void);
+
+/* ------------------------------------------------------------
+   33) The Main Menu
+   ------------------------------------------------------------ */
+
+/**
+ * @brief The main driver loop for the program (new pokedex, merge, fight, etc.).
+ * Why we made it: Our top-level UI that keeps the user engaged until they exit.
+ */
+void mainMenu(void);
+
+// Array of Pokemon data
+static const PokemonData pokedex[] = {
+    {1, "Bulbasaur", GRASS, 45, 49, CAN_EVOLVE},
+    {2, "Ivysaur", GRASS, 60, 62, CAN_EVOLVE},
+    {3, "Venusaur", GRASS, 80, 82, CANNOT_EVOLVE},
+    {4, "Charmander", FIRE, 39, 52, CAN_EVOLVE},
+    {5, "Charmeleon", FIRE, 58, 64, CAN_EVOLVE},
+    {6, "Charizard", FIRE, 78, 84, CANNOT_EVOLVE},
+    {7, "Squirtle", WATER, 44, 48, CAN_EVOLVE},
+    {8, "Wartortle", WATER, 59, 63, CAN_EVOLVE},
+    {9, "Blastoise", WATER, 79, 83, CANNOT_EVOLVE},
+    {10, "Caterpie", BUG, 45, 30, CAN_EVOLVE},
+    {11, "Metapod", BUG, 50, 20, CAN_EVOLVE},
+    {12, "Butterfree", BUG, 60, 45, CANNOT_EVOLVE},
+    {13, "Weedle", BUG, 40, 35, CAN_EVOLVE},
+    {14, "Kakuna", BUG, 45, 25, CAN_EVOLVE},
+    {15, "Beedrill", BUG, 65, 90, CANNOT_EVOLVE},
+    {16, "Pidgey", NORMAL, 40, 45, CAN_EVOLVE},
+    {17, "Pidgeotto", NORMAL, 63, 60, CAN_EVOLVE},
+    {18, "Pidgeot", NORMAL, 83, 80, CANNOT_EVOLVE},
+    {19, "Rattata", NORMAL, 30, 56, CAN_EVOLVE},
+    {20, "Raticate", NORMAL, 55, 81, CANNOT_EVOLVE},
+    {21, "Spearow", NORMAL, 40, 60, CAN_EVOLVE},
+    {22, "Fearow", NORMAL, 65, 90, CANNOT_EVOLVE},
+    {23, "Ekans", POISON, 35, 60, CAN_EVOLVE},
+    {24, "Arbok", POISON, 60, 85, CANNOT_EVOLVE},
+    {25, "Pikachu", ELECTRIC, 35, 55, CAN_EVOLVE},
+    {26, "Raichu", ELECTRIC, 60, 90, CANNOT_EVOLVE},
+    {27, "Sandshrew", GROUND, 50, 75, CAN_EVOLVE},
+    {28, "Sandslash", GROUND, 75, 100, CANNOT_EVOLVE},
+    {29, "NidoranF", POISON, 55, 47, CAN_EVOLVE},
+    {30, "Nidorina", POISON, 70, 62, CAN_EVOLVE},
+    {31, "Nidoqueen", POISON, 90, 92, CANNOT_EVOLVE},
+    {32, "NidoranM", POISON, 46, 57, CAN_EVOLVE},
+    {33, "Nidorino", POISON, 61, 72, CAN_EVOLVE},
+    {34, "Nidoking", POISON, 81, 102, CANNOT_EVOLVE},
+    {35, "Clefairy", FAIRY, 70, 45, CAN_EVOLVE},
+    {36, "Clefable", FAIRY, 95, 70, CANNOT_EVOLVE},
+    {37, "Vulpix", FIRE, 38, 41, CAN_EVOLVE},
+    {38, "Ninetales", FIRE, 73, 76, CANNOT_EVOLVE},
+    {39, "Jigglypuff", NORMAL, 115, 45, CAN_EVOLVE},
+    {40, "Wigglytuff", NORMAL, 140, 70, CANNOT_EVOLVE},
+    {41, "Zubat", POISON, 40, 45, CAN_EVOLVE},
+    {42, "Golbat", POISON, 75, 80, CAN_EVOLVE},
+    {43, "Oddish", GRASS, 45, 50, CAN_EVOLVE},
+    {44, "Gloom", GRASS, 60, 65, CAN_EVOLVE},
+    {45, "Vileplume", GRASS, 75, 80, CANNOT_EVOLVE},
+    {46, "Paras", BUG, 35, 70, CAN_EVOLVE},
+    {47, "Parasect", BUG, 60, 95, CANNOT_EVOLVE},
+    {48, "Venonat", BUG, 60, 55, CAN_EVOLVE},
+    {49, "Venomoth", BUG, 70, 65, CANNOT_EVOLVE},
+    {50, "Diglett", GROUND, 10, 55, CAN_EVOLVE},
+    {51, "Dugtrio", GROUND, 35, 80, CANNOT_EVOLVE},
+    {52, "Meowth", NORMAL, 40, 45, CAN_EVOLVE},
+    {53, "Persian", NORMAL, 65, 70, CANNOT_EVOLVE},
+    {54, "Psyduck", WATER, 50, 52, CAN_EVOLVE},
+    {55, "Golduck", WATER, 80, 82, CANNOT_EVOLVE},
+    {56, "Mankey", FIGHTING, 40, 80, CAN_EVOLVE},
+    {57, "Primeape", FIGHTING, 65, 105, CANNOT_EVOLVE},
+    {58, "Growlithe", FIRE, 55, 70, CAN_EVOLVE},
+    {59, "Arcanine", FIRE, 90, 110, CANNOT_EVOLVE},
+    {60, "Poliwag", WATER, 40, 50, CAN_EVOLVE},
+    {61, "Poliwhirl", WATER, 65, 65, CAN_EVOLVE},
+    {62, "Poliwrath", WATER, 90, 95, CANNOT_EVOLVE},
+    {63, "Abra", PSYCHIC, 25, 20, CAN_EVOLVE},
+    {64, "Kadabra", PSYCHIC, 40, 35, CAN_EVOLVE},
+    {65, "Alakazam", PSYCHIC, 55, 50, CANNOT_EVOLVE},
+    {66, "Machop", FIGHTING, 70, 80, CAN_EVOLVE},
+    {67, "Machoke", FIGHTING, 80, 100, CAN_EVOLVE},
+    {68, "Machamp", FIGHTING, 90, 130, CANNOT_EVOLVE},
+    {69, "Bellsprout", GRASS, 50, 75, CAN_EVOLVE},
+    {70, "Weepinbell", GRASS, 65, 90, CAN_EVOLVE},
+    {71, "Victreebel", GRASS, 80, 105, CANNOT_EVOLVE},
+    {72, "Tentacool", WATER, 40, 40, CAN_EVOLVE},
+    {73, "Tentacruel", WATER, 80, 70, CANNOT_EVOLVE},
+    {74, "Geodude", ROCK, 40, 80, CAN_EVOLVE},
+    {75, "Graveler", ROCK, 55, 95, CAN_EVOLVE},
+    {76, "Golem", ROCK, 80, 120, CANNOT_EVOLVE},
+    {77, "Ponyta", FIRE, 50, 85, CAN_EVOLVE},
+    {78, "Rapidash", FIRE, 65, 100, CANNOT_EVOLVE},
+    {79, "Slowpoke", WATER, 90, 65, CAN_EVOLVE},
+    {80, "Slowbro", WATER, 95, 75, CANNOT_EVOLVE},
+    {81, "Magnemite", ELECTRIC, 25, 35, CAN_EVOLVE},
+    {82, "Magneton", ELECTRIC, 50, 60, CANNOT_EVOLVE},
+    {83, "Farfetch'd", NORMAL, 52, 65, CANNOT_EVOLVE},
+    {84, "Doduo", NORMAL, 35, 85, CAN_EVOLVE},
+    {85, "Dodrio", NORMAL, 60, 110, CANNOT_EVOLVE},
+    {86, "Seel", WATER, 65, 45, CAN_EVOLVE},
+    {87, "Dewgong", WATER, 90, 70, CANNOT_EVOLVE},
+    {88, "Grimer", POISON, 80, 80, CAN_EVOLVE},
+    {89, "Muk", POISON, 105, 105, CANNOT_EVOLVE},
+    {90, "Shellder", WATER, 30, 65, CAN_EVOLVE},
+    {91, "Cloyster", WATER, 50, 95, CANNOT_EVOLVE},
+    {92, "Gastly", GHOST, 30, 35, CAN_EVOLVE},
+    {93, "Haunter", GHOST, 45, 50, CAN_EVOLVE},
+    {94, "Gengar", GHOST, 60, 65, CANNOT_EVOLVE},
+    {95, "Onix", ROCK, 35, 45, CANNOT_EVOLVE},
+    {96, "Drowzee", PSYCHIC, 60, 48, CAN_EVOLVE},
+    {97, "Hypno", PSYCHIC, 85, 73, CANNOT_EVOLVE},
+    {98, "Krabby", WATER, 30, 105, CAN_EVOLVE},
+    {99, "Kingler", WATER, 55, 130, CANNOT_EVOLVE},
+    {100, "Voltorb", ELECTRIC, 40, 30, CAN_EVOLVE},
+    {101, "Electrode", ELECTRIC, 60, 50, CANNOT_EVOLVE},
+    {102, "Exeggcute", GRASS, 60, 40, CAN_EVOLVE},
+    {103, "Exeggutor", GRASS, 95, 95, CANNOT_EVOLVE},
+    {104, "Cubone", GROUND, 50, 50, CAN_EVOLVE},
+    {105, "Marowak", GROUND, 60, 80, CANNOT_EVOLVE},
+    {106, "Hitmonlee", FIGHTING, 50, 120, CANNOT_EVOLVE},
+    {107, "Hitmonchan", FIGHTING, 50, 105, CANNOT_EVOLVE},
+    {108, "Lickitung", NORMAL, 90, 55, CANNOT_EVOLVE},
+    {109, "Koffing", POISON, 40, 65, CAN_EVOLVE},
+    {110, "Weezing", POISON, 65, 90, CANNOT_EVOLVE},
+    {111, "Rhyhorn", GROUND, 80, 85, CAN_EVOLVE},
+    {112, "Rhydon", GROUND, 105, 130, CANNOT_EVOLVE},
+    {113, "Chansey", NORMAL, 250, 5, CANNOT_EVOLVE},
+    {114, "Tangela", GRASS, 65, 55, CANNOT_EVOLVE},
+    {115, "Kangaskhan", NORMAL, 105, 95, CANNOT_EVOLVE},
+    {116, "Horsea", WATER, 30, 40, CAN_EVOLVE},
+    {117, "Seadra", WATER, 55, 65, CANNOT_EVOLVE},
+    {118, "Goldeen", WATER, 45, 67, CAN_EVOLVE},
+    {119, "Seaking", WATER, 80, 92, CANNOT_EVOLVE},
+    {120, "Staryu", WATER, 30, 45, CAN_EVOLVE},
+    {121, "Starmie", WATER, 60, 75, CANNOT_EVOLVE},
+    {122, "Mr. Mime", PSYCHIC, 40, 45, CANNOT_EVOLVE},
+    {123, "Scyther", BUG, 70, 110, CANNOT_EVOLVE},
+    {124, "Jynx", ICE, 65, 50, CANNOT_EVOLVE},
+    {125, "Electabuzz", ELECTRIC, 65, 83, CANNOT_EVOLVE},
+    {126, "Magmar", FIRE, 65, 95, CANNOT_EVOLVE},
+    {127, "Pinsir", BUG, 65, 125, CANNOT_EVOLVE},
+    {128, "Tauros", NORMAL, 75, 100, CANNOT_EVOLVE},
+    {129, "Magikarp", WATER, 20, 10, CAN_EVOLVE},
+    {130, "Gyarados", WATER, 95, 125, CANNOT_EVOLVE},
+    {131, "Lapras", WATER, 130, 85, CANNOT_EVOLVE},
+    {132, "Ditto", NORMAL, 48, 48, CANNOT_EVOLVE},
+    {133, "Eevee", NORMAL, 55, 55, CAN_EVOLVE},
+    {134, "Vaporeon", WATER, 130, 65, CANNOT_EVOLVE},
     {135, "Jolteon", ELECTRIC, 65, 65, CANNOT_EVOLVE},
     {136, "Flareon", FIRE, 65, 130, CANNOT_EVOLVE},
     {137, "Porygon", NORMAL, 65, 60, CANNOT_EVOLVE},
@@ -612,4 +2294,17 @@ static const PokemonData pokedex[] = {
     {150, "Mewtwo", PSYCHIC, 106, 110, CANNOT_EVOLVE},
     {151, "Mew", PSYCHIC, 100, 100, CANNOT_EVOLVE}};
 
+// Number of species in the built-in pokedex[] table
+#define BUILTIN_POKEDEX_SIZE ((int)(sizeof(pokedex) / sizeof(pokedex[0])))
+
+// Active catalog: entry id - 1 holds species id. The built-in table unless
+// loadSpeciesCatalog replaced it at startup.
+const PokemonData *speciesCatalog = pokedex;
+int speciesCount = BUILTIN_POKEDEX_SIZE;
+// Backing storage of a loaded catalog
+PokemonData *catalogEntries = NULL;
+void *catalogMapping = NULL; // mmapped binary file
+size_t catalogMappingSize = 0;
+char *catalogNames = NULL;   // name block of a CSV file
+
 #endif // EX6_H